@@ -0,0 +1,169 @@
+/**
+ * ATIS IMA-ADPCM decoder program file.
+ * This file contains a decoder for voicepacks stored as IMA-ADPCM WAV files.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "adpcm.h"
+
+static const int16_t stepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t indexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+AudioGeneratorAdpcm::AudioGeneratorAdpcm(){
+    block = NULL;
+    running = false;
+}
+
+AudioGeneratorAdpcm::~AudioGeneratorAdpcm(){
+    free(block);
+}
+
+uint32_t readLittle(AudioFileSource* file, int bytes){
+    uint8_t data[4] = {};
+    file->read(data, bytes);
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+bool AudioGeneratorAdpcm::readHeader(){
+    if(readLittle(file, 4) != 0x46464952) return false;    // "RIFF"
+    readLittle(file, 4);
+    if(readLittle(file, 4) != 0x45564157) return false;    // "WAVE"
+
+    // Skip chunks until the sample data, reading the format on the way
+    bool format = false;
+    while(true){
+        uint32_t id = readLittle(file, 4);
+        uint32_t size = readLittle(file, 4);
+        if(id == 0 && size == 0) return false;
+
+        if(id == 0x20746d66){   // "fmt "
+            if(readLittle(file, 2) != 0x11) return false;
+            channels = readLittle(file, 2);
+            sampleRate = readLittle(file, 4);
+            readLittle(file, 4);
+            blockAlign = readLittle(file, 2);
+            if(readLittle(file, 2) != 4) return false;
+            if(!file->seek(size-16 + (size & 1), SEEK_CUR)) return false;
+            format = true;
+        }else if(id == 0x61746164){   // "data"
+            remaining = size;
+            return format && (channels == 1 || channels == 2) && blockAlign > 4*channels && blockAlign <= ADPCM_BLOCK_MAX;
+        }else if(!file->seek(size + (size & 1), SEEK_CUR)){
+            return false;
+        }
+    }
+}
+
+bool AudioGeneratorAdpcm::readBlock(){
+    uint32_t wanted = min(remaining, (uint32_t)blockAlign);
+    size_block = 0;
+    while(size_block < wanted){
+        uint32_t read = file->read(block+size_block, wanted-size_block);
+        if(read == 0) break;
+        size_block += read;
+    }
+    remaining -= size_block;
+    if(size_block <= 4*channels) return false;
+
+    // Each channel's header holds its first sample and step index, followed by 4-byte groups of samples for each channel in turn
+    for(int c=0; c<channels; c++){
+        predictor[c] = block[4*c] | (block[4*c+1] << 8);
+        index[c] = constrain(block[4*c+2], 0, 88);
+    }
+    samples = 1 + (size_block - 4*channels) * 2 / channels;
+    next = 0;
+    return true;
+}
+
+int16_t AudioGeneratorAdpcm::decodeSample(int channel){
+    if(next == 0) return predictor[channel];
+
+    int nibble = next - 1;
+    int offset = 4*channels + (nibble/8)*4*channels + 4*channel + (nibble%8)/2;
+    int code = (nibble & 1) ? block[offset] >> 4 : block[offset] & 0x0F;
+
+    int step = stepTable[index[channel]];
+    int diff = step >> 3;
+    if(code & 4) diff += step;
+    if(code & 2) diff += step >> 1;
+    if(code & 1) diff += step >> 2;
+    int sample = predictor[channel] + ((code & 8) ? -diff : diff);
+    predictor[channel] = constrain(sample, -32768, 32767);
+    index[channel] = constrain(index[channel] + indexTable[code & 7], 0, 88);
+    return predictor[channel];
+}
+
+bool AudioGeneratorAdpcm::begin(AudioFileSource* source, AudioOutput* output){
+    if(source == NULL || output == NULL) return false;
+    file = source;
+    this->output = output;
+    if(!file->isOpen() || !readHeader()) return false;
+
+    free(block);
+    block = (uint8_t*)malloc(blockAlign);
+    if(block == NULL) return false;
+    if(!readBlock()) return false;
+
+    if(!output->SetRate(sampleRate)) return false;
+    if(!output->SetBitsPerSample(16)) return false;
+    if(!output->SetChannels(channels)) return false;
+    if(!output->begin()) return false;
+
+    lastSample[0] = decodeSample(0);
+    lastSample[1] = channels == 2 ? decodeSample(1) : lastSample[0];
+    next++;
+    running = true;
+    return true;
+}
+
+bool AudioGeneratorAdpcm::loop(){
+    if(!running) return false;
+
+    // Samples are decoded only as fast as the output accepts them, keeping the last one until it does
+    while(output->ConsumeSample(lastSample)){
+        if(next >= samples && !readBlock()){
+            stop();
+            break;
+        }
+        lastSample[0] = decodeSample(0);
+        lastSample[1] = channels == 2 ? decodeSample(1) : lastSample[0];
+        next++;
+    }
+
+    file->loop();
+    output->loop();
+    return running;
+}
+
+bool AudioGeneratorAdpcm::stop(){
+    if(!running) return true;
+    running = false;
+    free(block);
+    block = NULL;
+    output->stop();
+    return true;
+}
+
+bool AudioGeneratorAdpcm::isRunning(){
+    return running;
+}
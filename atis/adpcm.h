@@ -0,0 +1,59 @@
+/**
+ * ATIS IMA-ADPCM decoder header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_ADPCM
+#define ATIS_ADPCM
+
+#include "AudioGenerator.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+
+/**
+ * @brief A decoder for WAV files with IMA-ADPCM compressed samples, which take a quarter of the space of 16-bit samples.
+ * Each block of the file is read into RAM and decoded one sample at a time as the output accepts them.
+ */
+class AudioGeneratorAdpcm : public AudioGenerator {
+    public:
+        AudioGeneratorAdpcm();
+        virtual ~AudioGeneratorAdpcm() override;
+
+        virtual bool begin(AudioFileSource* source, AudioOutput* output) override;
+        virtual bool loop() override;
+        virtual bool stop() override;
+        virtual bool isRunning() override;
+
+    private:
+        bool readHeader();
+        bool readBlock();
+        int16_t decodeSample(int channel);
+
+        uint8_t* block;
+        uint16_t channels;
+        uint32_t sampleRate;
+        uint16_t blockAlign;
+        uint32_t remaining;     // Bytes of sample data left in the file after the current block
+        uint32_t size_block;    // Bytes read into the current block
+        uint32_t samples;       // Samples per channel in the current block
+        uint32_t next;          // Index of the next sample to decode in the current block
+        int16_t predictor[2];
+        int8_t index[2];
+};
+
+#endif
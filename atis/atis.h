@@ -22,22 +22,50 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <SD.h>
+#include <LittleFS.h>
 
 #include "config.h"
 #include "helper.h"
+#include "log.h"
 
 #include "player.h"
 #include "networking.h"
 #include "parser.h"
+#include "poller.h"
+#include "history.h"
+#include "benchmark.h"
 
 /**
- * @brief Downloads the current METAR information, processes it, and converts it into an array of tokens.
+ * @brief Downloads the current METAR information and splits it into individual pieces of information.
+ * Also schedules the next background poll based on whether the METAR has changed.
  * 
- * @param[out] phrase A TokenType array, where the speech tokens corresponding to current METAR information will be written
- * @param[in] size_phrase The maximum size of `phrase`
- * @return The number of tokens written
+ * @param[out] parsed A pointer to an array of character pointers, where the pointers to each piece of METAR information will be written
+ * @param[in] size_parsed The maximum size of `parsed`
+ * @param[out] metar A char array where the decoded METAR information will be written. `parsed` points into this array
+ * @param[in] size_metar The maximum size of `metar`
+ * @param[out] changed Set to true if the METAR differs from the previously downloaded one, passed by reference
+ * @return The number of pieces written to `parsed`
  */
-int getNewMetarPhrase(TokenType* phrase, int size_phrase);
+int getNewMetar(char** parsed, int size_parsed, char* metar, int size_metar, bool& changed);
+
+/**
+ * @brief Appends the current METAR information to the history log, if the clock has been set.
+ * 
+ * @param[in] parsed A pointer to an array of character pointers, containing the pointers to each piece of METAR information
+ * @param[in] size_parsed The size of the `parsed` array
+ */
+void recordMetar(char** parsed, int size_parsed);
+
+/**
+ * @brief Downloads the current METAR information in the background and regenerates the phrase if the METAR has changed.
+ * Polls only happen between broadcasts, so a new METAR is spoken from the next broadcast on and never cuts one off.
+ */
+void pollMetar();
+
+/**
+ * @brief Interrupt handler for presses of the button, which cancels the broadcast in progress so that it starts again.
+ */
+void onButton();
 
 /**
  * @brief Loads a config file to a location in memory
@@ -18,19 +18,63 @@
 
 #include "atis.h"
 
-TokenType phrase[SIZE_PHRASE];
+// The phrase that is played and the previous one, which a new phrase is generated over while copying its unchanged pieces.
+// Each phrase keeps the split text of its report, which its segments point into
+TokenType phrase[2][SIZE_PHRASE];
+Segment segments[2][SIZE_PARSED];
+char metar[2][SIZE_METAR];
+int size_generated[2] = {0, 0};
+int size_segments[2] = {0, 0};
+int current = 0;
+int version = 0;
+unsigned long nextBroadcast = 0;
+char* parsed[SIZE_PARSED];
 char voicepack[SIZE_VOICEPACK];
+char speechRate[SIZE_SPEECH_RATE];
 char url[SIZE_URL];
 
-int getNewMetarPhrase(TokenType* phrase, int size_phrase){
+int getNewMetar(char** parsed, int size_parsed, char* metar, int size_metar, bool& changed){
     char response[SIZE_RESPONSE];
-    char metar[SIZE_METAR];
-    char* parsed[SIZE_PARSED];
     getMetar(response, SIZE_RESPONSE, url);
-    int size_metar = decodeMetar(metar, SIZE_METAR, response, SIZE_RESPONSE);
-    int size_parsed = parseMetar(parsed, SIZE_PARSED, metar, size_metar);
-    int size_generated = generatePhrase(phrase, size_phrase, parsed, size_parsed);
-    return size_generated;
+    int size_decoded = decodeMetar(metar, size_metar, response, SIZE_RESPONSE);
+    bool failed = strcmp(metar, "ERROR") == 0;
+    changed = updateMetar(metar);
+    schedulePoll(changed, failed);
+    return parseMetar(parsed, size_parsed, metar, size_decoded);
+}
+
+void recordMetar(char** parsed, int size_parsed){
+    // Reports are only logged once the clock has been set, so that the log stays ordered by time
+    time_t now = time(nullptr);
+    if(now < HISTORY_EPOCH) return;
+
+    MetarRecord record;
+    buildRecord(record, parsed, size_parsed, now);
+    if(!appendRecord(record)) LOG(HISTORY_FAILED);
+}
+
+void pollMetar(){
+    bool changed;
+    int next = 1-current;
+    int size_parsed = getNewMetar(parsed, SIZE_PARSED, metar[next], SIZE_METAR, changed);
+    if(!changed) return;
+
+    LOG(NEW_METAR);
+    size_generated[next] = generatePhrase(phrase[next], SIZE_PHRASE, segments[next], parsed, size_parsed, phrase[current], metar[current], segments[current], size_segments[current]);
+    size_segments[next] = size_parsed;
+    countTokens(phrase[next], size_generated[next]);
+    recordMetar(parsed, size_parsed);
+    // Polls only happen between broadcasts, so the phrase can be swapped without cutting one off
+    current = next;
+    version++;
+}
+
+void IRAM_ATTR onButton(){
+    static unsigned long lastPress = 0;
+    unsigned long now = millis();
+    if(now - lastPress < BUTTON_DEBOUNCE) return;
+    lastPress = now;
+    cancelPlayback(X_BUTTON);
 }
 
 void loadConfig(char* target, int size_target, const char* defaultText, const char* filepath){
@@ -60,47 +104,105 @@ void setup(){
     pinMode(PIN_LED, OUTPUT);
     digitalWrite(PIN_LED, HIGH);  // Turn on setup light
     pinMode(PIN_BUTTON, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(PIN_BUTTON), onButton, FALLING);
 
-    D_SerialBegin(115200);
-    D_println();
+    beginLog(115200);
 
     if (!SD.begin(PIN_CS)){
-        D_println("SD initialisation failed");
+        LOG(SD_FAILED);
     }else{
-        D_println("SD initialised");
+        LOG(SD_READY);
+    }
+
+    if(!LittleFS.begin()){
+        LOG(LITTLEFS_FAILED);
     }
 
     char ssid[SIZE_SSID];
     char password[SIZE_PASSWORD];
 
     loadConfig(voicepack, SIZE_VOICEPACK, VOICEPACK, PATH_VOICEPACK);
+    loadConfig(speechRate, SIZE_SPEECH_RATE, SPEECH_RATE, PATH_SPEECH_RATE);
     loadConfig(url, SIZE_URL, URL, PATH_URL);
     loadConfig(ssid, SIZE_SSID, WIFI_SSID, PATH_SSID);
     loadConfig(password, SIZE_PASSWORD, WIFI_PASSWORD, PATH_PASSWORD);
 
-    D_print("Voicepack in use: "); D_println(voicepack);
-    D_print("URL in use: "); D_println(url);
-    D_print("WiFi SSID in use: "); D_println(ssid);
-    D_print("WiFi password in use: "); D_println(password);
+    if(BENCHMARK){
+        char packs[] = BENCHMARK_PACKS;
+        for(char* pack=strtok(packs, " "); pack!=NULL; pack=strtok(NULL, " ")) benchmarkVoicepack(pack);
+        benchmarkTimeScale();
+        benchmarkParser();
+    }
+
+    setSpeechRate(atoi(speechRate));
+    loadFormat(voicepack);
+    loadCache(voicepack);
+    loadCompounds(voicepack);
+
+    LOG(CONFIG, "Voicepack", voicepack);
+    LOG(CONFIG, "Voicepack format", formatNames[getFormat()]);
+    LOG(CONFIG, "Speech rate", speechRate);
+    LOG(CONFIG, "URL", url);
+    LOG(CONFIG, "WiFi SSID", ssid);
+    LOG(CONFIG, "WiFi password", password);
 
     WiFi.mode(WIFI_STA);
     WiFi.begin(ssid, password);
 
-    while(WiFi.status() != WL_CONNECTED) delay(100);
-    D_println("WiFi connected");
+    while(WiFi.status() != WL_CONNECTED){
+        flushLog();
+        delay(100);
+    }
+    LOG(WIFI_CONNECTED);
+    configTime(0, 0, NTP_SERVER);
 
     // Turn off setup light
     digitalWrite(PIN_LED, LOW);
 }
 
 void loop(){
-    if(digitalRead(PIN_BUTTON) == HIGH) return;
+    // A pending press restarts the broadcast first, and the poll waits until the next loop instead of delaying it by a download
+    if(isPollDue() && getCancelReason() == X_NONE) pollMetar();
+
+    // A press during a broadcast cancels it, and the broadcast starts again from the top
+    bool pressed = clearCancel() != X_NONE;
+    // When looping, new reports are only swapped in here, between repeats, so a message is never cut off.
+    // Looping only starts once a phrase has been generated in the background, so that downloads keep to the poll schedule
+    bool looping = BROADCAST_LOOP && size_generated[current] > 0;
+    if(looping && nextBroadcast == 0) nextBroadcast = millis();
+    bool due = looping && (long)(millis() - nextBroadcast) >= 0;
+    if(!pressed && !due && digitalRead(PIN_BUTTON) == HIGH){
+        // The log is only written out while idle, so that it never delays speech
+        flushLog();
+        updateCache(voicepack, []{ return getCancelReason() != X_NONE; });
+        return;
+    }
 
     digitalWrite(PIN_LED, HIGH);
-    int size_generated = getNewMetarPhrase(phrase, SIZE_PHRASE);
-    D_println("Generation complete!");
-    //for(int i=0; i<size_generated; i++) playToken(phrase[i], voicepack);
-    for(int i=0; i<117; i++) playToken(TokenType(i), voicepack);
-    D_println("End of loop\n-----------------------\n");
+    unsigned long start = millis();
+    if(size_generated[current] > 0){
+        // A current phrase was already generated in the background
+        playTokens(phrase[current], size_generated[current], voicepack);
+        if(due){
+            // How late the repeat started shows whether downloads or caching between repeats hold up the frequency
+            unsigned long duration = max(millis()-start, 1ul);
+            LOG(REPEATED, version, start-nextBroadcast, getDecodeTime()/10/duration, duration);
+        }
+    }else{
+        bool changed;
+        int size_parsed = getNewMetar(parsed, SIZE_PARSED, metar[current], SIZE_METAR, changed);
+        int size_phrase = speakMetar(phrase[current], SIZE_PHRASE, segments[current], parsed, size_parsed, voicepack, start);
+        if(changed){
+            size_generated[current] = size_phrase;
+            size_segments[current] = size_parsed;
+            version++;
+            countTokens(phrase[current], size_phrase);
+            recordMetar(parsed, size_parsed);
+        }
+    }
+    LOG(BROADCAST, getCancelReason() == X_NONE ? "finished" : "cancelled", millis()-start);
+    // Without a phrase, the schedule starts again when the first one is generated
+    if(BROADCAST_LOOP) nextBroadcast = size_generated[current] > 0 ? millis() + BROADCAST_GAP : 0;
+    LOG(LOOP_END);
     digitalWrite(PIN_LED, LOW);
 }
@@ -0,0 +1,202 @@
+/**
+ * ATIS voicepack benchmark program file.
+ * This file contains the logic to measure how expensive each voicepack format is to decode.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.h"
+
+AudioOutputCount::AudioOutputCount(){
+    samples = 0;
+}
+
+bool AudioOutputCount::begin(){
+    samples = 0;
+    return true;
+}
+
+bool AudioOutputCount::ConsumeSample(int16_t sample[2]){
+    samples++;
+    return true;
+}
+
+bool AudioOutputCount::stop(){
+    return true;
+}
+
+uint32_t AudioOutputCount::getSamples(){
+    return samples;
+}
+
+int AudioOutputCount::getRate(){
+    return hertz;
+}
+
+void benchmarkVoicepack(const char* voicepack){
+    ClipFormat format = loadFormat(voicepack);
+    int clips = 0;
+    uint32_t bytes = 0;
+    float seconds = 0;
+    uint64_t cycles = 0;
+    uint32_t peakHeap = 0;
+    // The read-ahead buffer is only allocated while benchmarking, instead of taking up RAM for good
+    AudioFileSourcePrefetch* benchmarkClip = new AudioFileSourcePrefetch();
+
+    LOG(BENCHMARK, voicepack, formatNames[format]);
+    for(int i=0; i<TOKEN_COUNT; i++){
+        char path[100];
+        clipPath(path, 100, tokenFilenames[i], voicepack);
+        if(!benchmarkClip->open(path)) continue;
+
+        uint32_t heap = ESP.getFreeHeap();
+        uint32_t lowest = heap;
+        uint64_t clipCycles = 0;
+        AudioOutputCount* out = new AudioOutputCount();
+        AudioGenerator* aud = createDecoder(format);
+
+        // The decoder reads the SD card from inside its loop, so reading is part of the CPU time
+        uint32_t start = ESP.getCycleCount();
+        bool running = aud->begin(benchmarkClip, out);
+        clipCycles += ESP.getCycleCount() - start;
+        while(running){
+            lowest = min(lowest, ESP.getFreeHeap());
+            start = ESP.getCycleCount();
+            running = aud->loop();
+            clipCycles += ESP.getCycleCount() - start;
+            yield();
+        }
+        aud->stop();
+
+        uint32_t samples = out->getSamples();
+        int rate = out->getRate();
+        delete aud;
+        delete out;
+        benchmarkClip->close();
+
+        LOG(BENCHMARK_CLIP, tokenFilenames[i], benchmarkClip->getBytesRead(), samples, rate, clipCycles / ESP.getCpuFreqMHz(), heap - lowest);
+        // Decoding is not timed while the log is written out, so the log can wait for the serial port here
+        while(!flushLog()) yield();
+
+        clips++;
+        bytes += benchmarkClip->getBytesRead();
+        if(rate > 0) seconds += (float)samples / rate;
+        cycles += clipCycles;
+        peakHeap = max(peakHeap, heap - lowest);
+    }
+    delete benchmarkClip;
+
+    if(clips == 0 || seconds == 0){
+        LOG(BENCHMARK_EMPTY);
+        return;
+    }
+    LOG(BENCHMARK_SUMMARY, clips, seconds * 1000, cycles / ESP.getCpuFreqMHz() / 1000 / seconds, bytes / seconds, peakHeap);
+}
+
+void benchmarkTimeScale(){
+    const int hz = 22050;
+    const int seconds = 2;
+    // A 150 Hz voice with a 700 Hz formant repeats every 20 ms, so one period is enough as the test signal
+    int16_t signal[hz/50];
+    for(int i=0; i<hz/50; i++) signal[i] = 8000*sin(2*PI*150*i/hz) + 4000*sin(2*PI*700*i/hz);
+
+    AudioOutputCount* out = new AudioOutputCount();
+    for(int rate : {125, 150, 200}){
+        uint32_t heap = ESP.getFreeHeap();
+        AudioOutputTimeScale* timescale = new AudioOutputTimeScale(out, rate);
+        uint32_t used = heap - ESP.getFreeHeap();
+        timescale->SetRate(hz);
+        timescale->SetChannels(1);
+        timescale->begin();
+
+        uint32_t cycles = 0;
+        for(int i=0; i<hz*seconds; i+=hz/50){
+            uint32_t start = ESP.getCycleCount();
+            for(int j=0; j<hz/50; j++){
+                int16_t sample[2] = {signal[j], signal[j]};
+                timescale->ConsumeSample(sample);
+            }
+            cycles += ESP.getCycleCount() - start;
+            yield();
+        }
+        timescale->stop();
+        delete timescale;
+
+        LOG(BENCHMARK_TIMESCALE, rate, cycles / ESP.getCpuFreqMHz() / seconds, out->getSamples(), hz*seconds, used);
+        while(!flushLog()) yield();
+    }
+    delete out;
+}
+
+void benchmarkParser(){
+    const int rounds = 20;
+    const char* reports[] = {
+        "ILZM 011250Z AUTO 24010G20KT 210V280 9999 -SHRA FEW030CB BKN045 M05\\/M07 Q1013",
+        "EFHK 011250Z 05004KT 0800 R04\\/M0050U R15\\/P1500N FG VV002 02\\/02 Q1021 NOSIG",
+        "ILZD 011250Z AUTO \\/\\/\\/\\/\\/KT \\/\\/\\/\\/ \\/\\/ \\/\\/\\/\\/\\/\\/ \\/\\/\\/\\/ Q\\/\\/\\/\\/",
+        "ILZM 011320Z AUTO VRB03KT CAVOK 18\\/09 Q1008 WS ALL RWY",
+    };
+    char metar[SIZE_METAR];
+    char* parsed[SIZE_PARSED];
+    uint32_t bytes = 0;
+    uint32_t splitCycles = 0;
+    int groups = 0;
+    int tried = 0;
+    int triedAll = 0;
+    uint64_t classifyCycles = 0;
+    uint64_t classifyAllCycles = 0;
+
+    for(int i=0; i<rounds; i++){
+        for(const char* report : reports){
+            int size_metar = snprintf(metar, SIZE_METAR, "%s", report);
+            uint32_t start = ESP.getCycleCount();
+            int size_parsed = parseMetar(parsed, SIZE_PARSED, metar, size_metar);
+            splitCycles += ESP.getCycleCount() - start;
+            bytes += size_metar;
+
+            for(int j=0; j<size_parsed; j++){
+                std::cmatch match;
+                start = ESP.getCycleCount();
+                InformationType type = classifyGroup(parsed[j], match);
+                classifyCycles += ESP.getCycleCount() - start;
+
+                // Every clause is tried in order until one matches, as before the shape check
+                start = ESP.getCycleCount();
+                for(const GroupPattern& it : regexToToken){
+                    triedAll++;
+                    if(std::regex_match(parsed[j], match, std::regex(it.regex))) break;
+                }
+                classifyAllCycles += ESP.getCycleCount() - start;
+
+                int length;
+                uint8_t classes = groupClasses(parsed[j], length);
+                for(const GroupPattern& it : regexToToken){
+                    if((classes & ~it.classes) != 0 || length < it.minLength || length > it.maxLength) continue;
+                    tried++;
+                    if(it.type == type) break;
+                }
+                groups++;
+            }
+            yield();
+        }
+        // Logging is not timed, so the log can wait for the serial port here
+        while(!flushLog()) yield();
+    }
+
+    uint32_t mhz = ESP.getCpuFreqMHz();
+    LOG(BENCHMARK_PARSER, (uint64_t)bytes * mhz * 1000 / max(splitCycles, 1u) * 1000 / 1024, classifyCycles / mhz * 10 / groups, tried * 10 / groups,
+        classifyAllCycles / mhz * 10 / groups, triedAll * 10 / groups);
+    while(!flushLog()) yield();
+}
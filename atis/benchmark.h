@@ -0,0 +1,85 @@
+/**
+ * ATIS voicepack benchmark header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_BENCHMARK
+#define ATIS_BENCHMARK
+
+#include "AudioOutput.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+#include "log.h"
+#include "cache.h"
+#include "format.h"
+#include "prefetch.h"
+#include "timescale.h"
+#include "networking.h"
+#include "parser.h"
+
+/**
+ * @brief An audio output that discards the decoded samples after counting them, so that only the decoder is measured.
+ */
+class AudioOutputCount : public AudioOutput {
+    public:
+        AudioOutputCount();
+
+        virtual bool begin() override;
+        virtual bool ConsumeSample(int16_t sample[2]) override;
+        virtual bool stop() override;
+
+        /**
+         * @brief Gets the number of samples consumed since the output was started.
+         * 
+         * @return The number of samples
+         */
+        uint32_t getSamples();
+
+        /**
+         * @brief Gets the sample rate set by the decoder.
+         * 
+         * @return The sample rate in Hz
+         */
+        int getRate();
+
+    private:
+        uint32_t samples;
+};
+
+/**
+ * @brief Decodes every clip of a voicepack as fast as possible and prints the cost of its format.
+ * For each clip, the CPU time, the bytes read from the SD card and the peak heap used by the decoder are printed,
+ * followed by a summary of the CPU time and bytes per second of audio, so that the cheapest format can be chosen.
+ * The format of the voicepack in use must be loaded again with `loadFormat()` afterwards.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ */
+void benchmarkVoicepack(const char* voicepack);
+
+/**
+ * @brief Measures the CPU time and heap that the time-scaler needs at several speech rates, on a synthetic vowel-like signal.
+ */
+void benchmarkTimeScale();
+
+/**
+ * @brief Measures the cost of splitting and classifying sample METAR reports.
+ * Classification is timed both with the shape check that skips regex clauses which cannot match, and by trying every clause in order.
+ */
+void benchmarkParser();
+
+#endif
@@ -0,0 +1,204 @@
+/**
+ * ATIS token audio cache program file.
+ * This file contains the logic to keep the most frequently spoken tokens decoded in flash.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cache.h"
+
+uint32_t tokenCounts[TOKEN_COUNT];
+uint32_t cachedSizes[TOKEN_COUNT];  // Size of the cached file, or 0 if the token is not cached
+uint32_t decodedSizes[TOKEN_COUNT]; // Size of the token's file when it was last decoded, or 0 if unknown
+bool cacheDirty = false;            // Whether the frequencies have changed since the cache last matched them
+
+AudioOutputFile::AudioOutputFile(const char* path){
+    strncpy(this->path, path, sizeof(this->path));
+    this->path[sizeof(this->path)-1] = '\0';
+    size_data = 0;
+    size_buffer = 0;
+}
+
+bool AudioOutputFile::begin(){
+    file = LittleFS.open(path, "w");
+    if(!file) return false;
+
+    size_data = 0;
+    size_buffer = 0;
+    writeHeader();
+    return true;
+}
+
+bool AudioOutputFile::ConsumeSample(int16_t sample[2]){
+    // 8-bit clips come in unsigned and are widened here, since the cached file is always 16 bits
+    int16_t stereo[2] = {sample[LEFTCHANNEL], sample[RIGHTCHANNEL]};
+    MakeSampleStereo16(stereo);
+    int16_t mono = channels == 1 ? stereo[LEFTCHANNEL] : (stereo[LEFTCHANNEL]>>1) + (stereo[RIGHTCHANNEL]>>1);
+    buffer[size_buffer++] = mono & 0xFF;
+    buffer[size_buffer++] = (uint16_t)mono >> 8;
+    size_data += 2;
+    if(size_buffer > SIZE_CACHE_WRITE-2) writeBuffer();
+    return true;
+}
+
+void AudioOutputFile::writeBuffer(){
+    file.write(buffer, size_buffer);
+    size_buffer = 0;
+}
+
+bool AudioOutputFile::stop(){
+    if(!file) return false;
+    writeBuffer();
+
+    // The sizes are only known once all samples are written
+    file.seek(0);
+    writeHeader();
+    file.close();
+    return true;
+}
+
+uint32_t AudioOutputFile::getSize(){
+    return size_data + 44;
+}
+
+void AudioOutputFile::writeHeader(){
+    uint32_t rate = hertz;
+    uint32_t header[11] = {
+        0x46464952, size_data+36, 0x45564157,                   // "RIFF", size, "WAVE"
+        0x20746D66, 16, 1 | (1 << 16), rate, rate*2, 2 | (16 << 16), // "fmt ", PCM, mono, 16 bits
+        0x61746164, size_data,                                  // "data", size
+    };
+    file.write((const uint8_t*)header, sizeof(header));
+}
+
+void cachePath(char* path, int size_path, TokenType token, const char* voicepack){
+    snprintf(path, size_path, "/cache/%s/%s.wav", voicepack, tokenFilenames[token]);
+}
+
+void loadCache(const char* voicepack){
+    memset(tokenCounts, 0, sizeof(tokenCounts));
+    memset(cachedSizes, 0, sizeof(cachedSizes));
+    memset(decodedSizes, 0, sizeof(decodedSizes));
+
+    File counts = LittleFS.open(PATH_COUNTS, "r");
+    if(counts){
+        counts.read((uint8_t*)tokenCounts, sizeof(tokenCounts));
+        counts.close();
+    }
+
+    char path[50];
+    for(int i=0; i<TOKEN_COUNT; i++){
+        cachePath(path, 50, TokenType(i), voicepack);
+        if(!LittleFS.exists(path)) continue;
+
+        File clip = LittleFS.open(path, "r");
+        cachedSizes[i] = clip.size();
+        decodedSizes[i] = cachedSizes[i];
+        clip.close();
+    }
+    cacheDirty = true;
+}
+
+bool isCached(TokenType token){
+    return cachedSizes[token] > 0;
+}
+
+void countTokens(const TokenType* phrase, int size_phrase){
+    for(int i=0; i<size_phrase; i++) tokenCounts[phrase[i]]++;
+    cacheDirty = true;
+
+    File counts = LittleFS.open(PATH_COUNTS, "w");
+    if(!counts) return;
+    counts.write((const uint8_t*)tokenCounts, sizeof(tokenCounts));
+    counts.close();
+}
+
+bool decodeToken(TokenType token, const char* voicepack, bool (*cancelled)()){
+    char source[100];
+    char target[50];
+    clipPath(source, 100, tokenFilenames[token], voicepack);
+    cachePath(target, 50, token, voicepack);
+    if(!SD.exists(source)) return false;
+
+    LOG(CACHING, target);
+    AudioFileSourceSD* clip = new AudioFileSourceSD(source);
+    AudioOutputFile* out = new AudioOutputFile(target);
+    AudioGenerator* aud = createDecoder(getFormat());
+
+    // Checking after every decoder step keeps a button press from waiting for the whole clip to be decoded
+    bool success = aud->begin(clip, out);
+    while(aud->loop()){
+        if(cancelled()){
+            success = false;
+            break;
+        }
+        yield();
+    }
+    aud->stop();
+    uint32_t size = out->getSize();
+
+    delete aud;
+    delete out;
+    delete clip;
+
+    if(!success){
+        LittleFS.remove(target);
+        return false;
+    }
+    cachedSizes[token] = size;
+    decodedSizes[token] = size;
+    return true;
+}
+
+void updateCache(const char* voicepack, bool (*cancelled)()){
+    if(!cacheDirty) return;
+
+    bool visited[TOKEN_COUNT] = {};
+    uint32_t used = 0;
+
+    // Walk the tokens from the most to the least frequent
+    for(int n=0; n<TOKEN_COUNT; n++){
+        int token = -1;
+        for(int i=0; i<TOKEN_COUNT; i++){
+            if(visited[i]) continue;
+            if(token < 0 || tokenCounts[i] > tokenCounts[token]) token = i;
+        }
+        visited[token] = true;
+
+        bool wanted = tokenCounts[token] > 0;
+        if(isCached(TokenType(token))){
+            if(wanted && used + cachedSizes[token] <= CACHE_BUDGET){
+                used += cachedSizes[token];
+                continue;
+            }
+
+            char path[50];
+            cachePath(path, 50, TokenType(token), voicepack);
+            LOG(EVICTING, path);
+            LittleFS.remove(path);
+            cachedSizes[token] = 0;
+            return;
+        }
+
+        if(!wanted) continue;
+        if(decodedSizes[token] > 0 && used + decodedSizes[token] > CACHE_BUDGET) continue;
+        if(decodeToken(TokenType(token), voicepack, cancelled) || cancelled()) return;
+
+        // The voicepack has no usable clip for this token, so never try it again
+        decodedSizes[token] = CACHE_BUDGET+1;
+    }
+
+    cacheDirty = false;
+}
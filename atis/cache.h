@@ -0,0 +1,112 @@
+/**
+ * ATIS token audio cache header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_CACHE
+#define ATIS_CACHE
+
+#include <LittleFS.h>
+
+#include "AudioFileSourceSD.h"
+#include "AudioOutput.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+#include "log.h"
+#include "format.h"
+
+#define TOKEN_COUNT int(sizeof(tokenFilenames)/sizeof(tokenFilenames[0]))
+
+/**
+ * @brief An audio output that writes the decoded samples into a mono 16-bit WAV file in flash.
+ * Samples are collected in RAM and written in blocks of `SIZE_CACHE_WRITE` bytes, since every write to flash has a large fixed cost.
+ */
+class AudioOutputFile : public AudioOutput {
+    public:
+        /**
+         * @param[in] path A pointer to a char array with the path of the WAV file to write in LittleFS
+         */
+        AudioOutputFile(const char* path);
+
+        virtual bool begin() override;
+        virtual bool ConsumeSample(int16_t sample[2]) override;
+        virtual bool stop() override;
+
+        /**
+         * @brief Gets the number of bytes written to the file, including the header.
+         * 
+         * @return The size of the file
+         */
+        uint32_t getSize();
+
+    private:
+        void writeHeader();
+        void writeBuffer();
+
+        char path[50];
+        File file;
+        uint32_t size_data;
+        uint8_t buffer[SIZE_CACHE_WRITE];
+        int size_buffer;        // Number of bytes in `buffer`
+};
+
+/**
+ * @brief Writes the path of the cached WAV file of a token into a char array.
+ * 
+ * @param[out] path A char array to write the path to
+ * @param[in] size_path The maximum size of `path`
+ * @param[in] token The token whose path to write
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ */
+void cachePath(char* path, int size_path, TokenType token, const char* voicepack);
+
+/**
+ * @brief Loads the token frequencies and finds the tokens of the voicepack that are already cached in flash.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ */
+void loadCache(const char* voicepack);
+
+/**
+ * @brief Checks whether a token has been decoded into the cache.
+ * 
+ * @param[in] token The token to check
+ * @return true if the token can be played from flash without decoding it from the SD card
+ */
+bool isCached(TokenType token);
+
+/**
+ * @brief Adds the tokens of a newly generated phrase to the token frequencies and saves them in flash.
+ * 
+ * @param[in] phrase A TokenType array with the generated phrase
+ * @param[in] size_phrase The number of tokens in `phrase`
+ */
+void countTokens(const TokenType* phrase, int size_phrase);
+
+/**
+ * @brief Performs one step of bringing the cache in line with the token frequencies.
+ * The most frequent tokens that fit into `CACHE_BUDGET` bytes are kept in the cache.
+ * Each call either evicts one token that no longer fits or decodes one missing token, so it can be called when the device is idle.
+ * Decoding stops after the decoder step in which `cancelled` returns true, and the token is decoded again on a later call.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ * @param[in] cancelled A pointer to a function that returns true when the device is needed for something else
+ */
+void updateCache(const char* voicepack, bool (*cancelled)());
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * ATIS compound clip program file.
+ * This file contains the logic to replace sequences of tokens with single pre-recorded clips.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "compound.h"
+
+TrieNode trie[SIZE_TRIE] = {{ZERO, -1, -1, -1}};
+int size_trie = 1;
+char compounds[SIZE_COMPOUNDS][SIZE_COMPOUND_NAME];
+int size_compounds = 0;
+
+int findTokenByName(const char* name){
+    for(int i=0; i<int(sizeof(tokenFilenames)/sizeof(tokenFilenames[0])); i++){
+        if(strcmp(tokenFilenames[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+int findChild(int node, TokenType token){
+    for(int child=trie[node].child; child>=0; child=trie[child].sibling){
+        if(trie[child].token == token) return child;
+    }
+    return -1;
+}
+
+int addChild(int node, TokenType token){
+    int child = findChild(node, token);
+    if(child >= 0) return child;
+    if(size_trie >= SIZE_TRIE) return -1;
+
+    child = size_trie++;
+    trie[child] = {token, -1, trie[node].child, -1};
+    trie[node].child = child;
+    return child;
+}
+
+void addCompound(char* line){
+    char* name = strtok(line, " ");
+    if(name == NULL || size_compounds >= SIZE_COMPOUNDS) return;
+
+    int node = 0;
+    int length = 0;
+    for(char* word=strtok(NULL, " "); word!=NULL; word=strtok(NULL, " ")){
+        int token = findTokenByName(word);
+        if(token < 0) return;
+        node = addChild(node, TokenType(token));
+        if(node < 0) return;
+        length++;
+    }
+    if(length < 2) return;
+
+    strncpy(compounds[size_compounds], name, SIZE_COMPOUND_NAME);
+    compounds[size_compounds][SIZE_COMPOUND_NAME-1] = '\0';
+    trie[node].clip = size_compounds++;
+}
+
+int loadCompounds(const char* voicepack){
+    trie[0] = {ZERO, -1, -1, -1};
+    size_trie = 1;
+    size_compounds = 0;
+
+    char path[100];
+    snprintf(path, 100, "/audio/%s/compound.txt", voicepack);
+    if(!SD.exists(path)) return 0;
+    File manifest = SD.open(path, FILE_READ);
+    if(!manifest) return 0;
+
+    char line[SIZE_COMPOUND_LINE];
+    int pos = 0;
+    while(true){
+        int c = manifest.read();
+        if(c < 0 || c == '\n'){
+            line[pos] = '\0';
+            if(pos > 0 && line[pos-1] == '\r') line[pos-1] = '\0';
+            addCompound(line);
+            pos = 0;
+            if(c < 0) break;
+        }else if(pos < SIZE_COMPOUND_LINE-1){
+            line[pos++] = c;
+        }
+    }
+    manifest.close();
+
+    LOG(COMPOUNDS, size_compounds);
+    return size_compounds;
+}
+
+int matchCompound(const TokenType* tokens, int count, const char*& name){
+    int length = 0;
+    int node = 0;
+    for(int i=0; i<count; i++){
+        node = findChild(node, tokens[i]);
+        if(node < 0) break;
+        if(trie[node].clip < 0) continue;
+
+        length = i+1;
+        name = compounds[trie[node].clip];
+    }
+    return length;
+}
+
+bool extendsCompound(const TokenType* tokens, int count){
+    int node = 0;
+    for(int i=0; i<count; i++){
+        node = findChild(node, tokens[i]);
+        if(node < 0) return false;
+    }
+    return trie[node].child >= 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * ATIS compound clip header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_COMPOUND
+#define ATIS_COMPOUND
+
+#include <SD.h>
+
+#include "config.h"
+#include "helper.h"
+#include "log.h"
+
+// A node in the prefix trie of compound clips. Children are stored as a linked list of siblings to save memory
+struct TrieNode {
+    TokenType token;
+    int16_t child;
+    int16_t sibling;
+    int16_t clip;   // Index of the compound clip that ends at this node, or -1
+};
+
+/**
+ * @brief Loads the compound clip manifest of a voicepack into the prefix trie.
+ * Each line of the manifest contains the file name of a clip followed by the tokens it speaks, separated by spaces,
+ * for example `TEN_KILOMETERS ONE ZERO KILOMETERS`.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ * @return The number of compound clips loaded
+ */
+int loadCompounds(const char* voicepack);
+
+/**
+ * @brief Finds the longest compound clip that speaks the tokens at the start of a sequence.
+ * 
+ * @param[in] tokens A TokenType array with the tokens to match
+ * @param[in] count The number of tokens in `tokens`
+ * @param[out] name A pointer that will be set to the file name of the matched clip
+ * @return The number of tokens spoken by the matched clip, or 0 if no compound clip matches
+ */
+int matchCompound(const TokenType* tokens, int count, const char*& name);
+
+/**
+ * @brief Checks whether a sequence of tokens is the start of a compound clip that speaks more tokens,
+ * so that the match at its start may still grow once more tokens follow.
+ * 
+ * @param[in] tokens A TokenType array with the tokens to check
+ * @param[in] count The number of tokens in `tokens`
+ * @return true if a longer compound clip starts with all of `tokens`
+ */
+bool extendsCompound(const TokenType* tokens, int count);
+
+#endif
@@ -3,10 +3,36 @@
  * for example, pin assignments, the WiFi credentials, the URL, and other details.
  *  
  * The following values can be configured:
- * - DEBUG: Set to 1 to enable Serial and printing, 0 to disable
+ * - LOG_LEVEL: The most detailed events to log to Serial: 0 for none, 1 for errors, 2 for information and 3 for debugging.
+ *   The log is binary and can be turned into text with tools/log.py
+ * - SIZE_LOG: The number of bytes of log buffered in RAM until the program is idle. Must be a power of two
+ * - BENCHMARK: Set to 1 to measure the cost of decoding the voicepacks in BENCHMARK_PACKS at startup, 0 to disable. Requires LOG_LEVEL 2 or more
+ * - BENCHMARK_PACKS: The names of the voicepacks to benchmark, separated by spaces. The cost of time-scaling speech and parsing METAR reports is measured as well
  * - PIN_LED: The pin that the LED is connected to
  * - PIN_CS: The SD card's Chip Select pin 
- * - URL: The URL where ATIS gets its data. Currently only ilmailusaa.fi URLs are supported. 
+ * - BUTTON_DEBOUNCE: The time in milliseconds after a button press during which further presses are ignored
+ * - BROADCAST_LOOP: Set to 1 to repeat the broadcast continuously like an ATIS frequency, 0 to only play it when the button is pressed
+ * - BROADCAST_GAP: The time in milliseconds between the end of a repeated broadcast and the start of the next one
+ * - URL: The URL where ATIS gets its data. Several URLs may be given, separated by spaces. Currently only ilmailusaa.fi URLs are supported. 
+ * - SPEECH_RATE: The playback speed in percent (100-200). Speech is sped up without changing its pitch
+ * - FETCH_DEADLINE: The maximum time in milliseconds that downloading the METAR may take
+ * - FETCH_HEDGE_PERCENTILE: The percentile of recent download times after which a slow request is retried at the next endpoint
+ * - FETCH_HEDGE_DELAY: The time in milliseconds after which a slow request is retried until enough downloads have been timed
+ * - FETCH_HEDGE_HEAP: The free memory in bytes needed to keep a slow request open next to a plain http:// retry.
+ *   https:// retries always replace the slow request, since a second TLS connection does not fit in memory
+ * - FETCH_COMPRESSION: Set to 1 to ask the server for a gzip or deflate compressed response, 0 to disable.
+ *   The download stops once the METAR has arrived, so this only saves data when the METAR is not near the start of the response
+ * - INFLATE_WINDOW: The number of bytes of decompressed data kept for back-references. Must be a power of two
+ * - POLL_INTERVAL: The time in milliseconds between METAR issues, i.e. how long to wait after a new METAR before polling again
+ * - POLL_RETRY: The time in milliseconds to wait before polling again if the METAR has not changed yet
+ * - POLL_RETRY_MAX: The maximum backoff in milliseconds between retries of failed downloads
+ * - POLL_JITTER: The maximum random delay in milliseconds added to retries
+ * - PREFETCH_SECTORS: The number of SD card sectors of each audio clip to read ahead into RAM
+ * - ADPCM_BLOCK_MAX: The largest block size in bytes of IMA-ADPCM voicepacks
+ * - CACHE_BUDGET: The number of bytes of flash used to keep the most frequent tokens decoded
+ * - SIZE_CACHE_WRITE: The number of bytes of decoded samples collected in RAM before they are written to flash
+ * - NTP_SERVER: The time server used to timestamp the METAR history
+ * - HISTORY_STRIDE: The number of METAR history records between entries in the history's time index
  * 
  * Copyright (C) 2023-2024 PixelSergey
  *
@@ -27,28 +53,76 @@
 #ifndef ATIS_CONFIG
 #define ATIS_CONFIG
 
-#define DEBUG 1
+#define LOG_LEVEL 2
+#define SIZE_LOG 4096
+#define BENCHMARK 0
+#define BENCHMARK_PACKS "female male"
 #define PIN_LED D4
 #define PIN_CS D1
 #define PIN_BUTTON D2
+#define BUTTON_DEBOUNCE 50
+#define BROADCAST_LOOP 0
+#define BROADCAST_GAP 2000
 
 #define URL "https://ilmailusaa.fi/backend.php?{%22mode%22:%22awsaviation%22,%22radius%22:%22100%22,%22points%22:[{%22_locationName%22:%22ILZM%22}]}"
 #define PATH_URL "/url.txt"
 #define VOICEPACK "female"
 #define PATH_VOICEPACK "/voicepack.txt"
+#define SPEECH_RATE "100"
+#define PATH_SPEECH_RATE "/rate.txt"
 
 #define WIFI_SSID "SSID"
 #define WIFI_PASSWORD "PASSWORD"
 #define PATH_SSID "/ssid.txt"
 #define PATH_PASSWORD "/password.txt"
 
+#define FETCH_DEADLINE 10000
+#define FETCH_HEDGE_DELAY 3000
+#define FETCH_HEDGE_PERCENTILE 90
+#define FETCH_HEDGE_HEAP 8000
+#define FETCH_COMPRESSION 1
+
+#define POLL_INTERVAL 1800000
+#define POLL_RETRY 60000
+#define POLL_RETRY_MAX 900000
+#define POLL_JITTER 10000
+
 #define SIZE_PHRASE 200
 #define SIZE_RESPONSE 350
 #define SIZE_METAR 150
 #define SIZE_PARSED 25
 
+#define SIZE_SECTOR 512
+#define PREFETCH_SECTORS 4
+
+#define SIZE_TSM_FRAME 640
+
+#define ADPCM_BLOCK_MAX 2048
+
+#define CACHE_BUDGET 524288
+#define SIZE_CACHE_WRITE 512
+#define PATH_COUNTS "/cache/counts.bin"
+
+#define SIZE_TRIE 128
+#define SIZE_COMPOUNDS 32
+#define SIZE_COMPOUND_NAME 32
+#define SIZE_COMPOUND_LINE 200
+
+#define INFLATE_WINDOW 1024
+
+#define NTP_SERVER "pool.ntp.org"
+#define HISTORY_EPOCH 1700000000
+#define HISTORY_STRIDE 64
+#define PATH_HISTORY "/history.bin"
+#define PATH_HISTORY_INDEX "/history.idx"
+
 #define SIZE_VOICEPACK 20
-#define SIZE_URL 200
+#define SIZE_FORMAT 10
+#define SIZE_SPEECH_RATE 5
+#define SIZE_URL 600
+#define SIZE_ENDPOINTS 4
+#define SIZE_HOST 64
+#define SIZE_FETCH_HISTORY 20
 #define SIZE_SSID 50
 #define SIZE_PASSWORD 50
 
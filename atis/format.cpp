@@ -0,0 +1,62 @@
+/**
+ * ATIS voicepack format program file.
+ * This file contains the logic to find and decode voicepacks stored in different audio formats.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "format.h"
+
+ClipFormat clipFormat = A_MP3;
+
+ClipFormat loadFormat(const char* voicepack){
+    char path[50];
+    snprintf(path, 50, "/audio/%s/format.txt", voicepack);
+    clipFormat = A_MP3;
+
+    File config = SD.open(path, FILE_READ);
+    if(!config) return clipFormat;
+    char name[SIZE_FORMAT] = {};
+    config.read((uint8_t*)name, SIZE_FORMAT-1);
+    config.close();
+
+    name[strcspn(name, " \t\r\n")] = '\0';
+    for(int i=0; i<int(sizeof(formatNames)/sizeof(formatNames[0])); i++){
+        if(strcmp(name, formatNames[i]) == 0) clipFormat = ClipFormat(i);
+    }
+    return clipFormat;
+}
+
+ClipFormat getFormat(){
+    return clipFormat;
+}
+
+void clipPath(char* path, int size_path, const char* name, const char* voicepack){
+    snprintf(path, size_path, "/audio/%s/%s.%s", voicepack, name, formatExtensions[clipFormat]);
+}
+
+AudioGenerator* createDecoder(ClipFormat format){
+    switch(format){
+        case A_WAV:
+            return new AudioGeneratorWAV();
+
+        case A_ADPCM:
+            return new AudioGeneratorAdpcm();
+
+        default:
+        case A_MP3:
+            return new AudioGeneratorMP3();
+    }
+}
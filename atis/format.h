@@ -0,0 +1,79 @@
+/**
+ * ATIS voicepack format header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_FORMAT
+#define ATIS_FORMAT
+
+#include <SD.h>
+
+#include "AudioGeneratorMP3.h"
+#include "AudioGeneratorWAV.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+#include "adpcm.h"
+
+// This enum contains all the audio formats that a voicepack can be stored in
+enum ClipFormat {
+    A_MP3,
+    A_WAV,
+    A_ADPCM,
+};
+
+// The names of the formats, as written in a voicepack's format file
+constexpr const char* formatNames[] = {"mp3", "wav", "adpcm"};
+
+// The file extensions of the clips in each format
+constexpr const char* formatExtensions[] = {"mp3", "wav", "wav"};
+
+/**
+ * @brief Reads the format that a voicepack's clips are stored in from its format file on the SD card.
+ * Voicepacks without a format file are in MP3.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ * @return The format of the voicepack
+ */
+ClipFormat loadFormat(const char* voicepack);
+
+/**
+ * @brief Gets the format of the voicepack in use, as last loaded by `loadFormat()`.
+ * 
+ * @return The format of the voicepack
+ */
+ClipFormat getFormat();
+
+/**
+ * @brief Writes the path of a clip in the voicepack in use into a char array.
+ * 
+ * @param[out] path A char array to write the path to
+ * @param[in] size_path The maximum size of `path`
+ * @param[in] name A pointer to a char array with the clip's name, without the extension
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ */
+void clipPath(char* path, int size_path, const char* name, const char* voicepack);
+
+/**
+ * @brief Creates a decoder for clips in the voicepack's format. The decoder must be deleted by the caller.
+ * 
+ * @param[in] format The format of the clips to decode
+ * @return A pointer to the new decoder
+ */
+AudioGenerator* createDecoder(ClipFormat format);
+
+#endif
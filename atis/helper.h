@@ -20,22 +20,9 @@
 #ifndef ATIS_HELPER
 #define ATIS_HELPER
 
-#include "config.h"
-
-// Enable or disable debug printing and serial features
+#include <Arduino.h>
 
-#if DEBUG
-    #include <Arduino.h>
-    #define D_SerialBegin(...)  Serial.begin(__VA_ARGS__)
-    #define D_print(...)        Serial.print(__VA_ARGS__)
-    #define D_write(...)        Serial.write(__VA_ARGS__)
-    #define D_println(...)      Serial.println(__VA_ARGS__)
-#else
-    #define D_SerialBegin(...)
-    #define D_print(...)
-    #define D_write(...)
-    #define D_println(...)
-#endif
+#include "config.h"
 
 // Shortcuts
 
@@ -252,29 +239,56 @@ enum InformationType {
     I_ERROR,
 };
 
+// The tokens of a phrase that were generated from one piece of METAR information
+struct Segment {
+    uint32_t hash;              // FNV-1a hash of the piece of METAR information
+    InformationType type;
+    uint8_t start;              // Position of the first token in the phrase
+    uint8_t length;             // Number of tokens
+    uint8_t offset;             // Position of the piece of METAR information in the report's text
+};
+
+// Character classes of the shape of a piece of METAR information. A slash is escaped in the downloaded data, so it includes the backslash
+#define G_DIGIT 0x01
+#define G_LETTER 0x02
+#define G_SLASH 0x04
+#define G_SIGN 0x08
+#define G_OTHER 0x10
+
+// A regex clause, and the shape that a piece of METAR information must have for the clause to be able to match it:
+// the character classes it may contain and its length range. Checking the shape first means most pieces are matched
+// against only one regex, since compiling a regex is slow and takes a lot of memory on the NodeMCU
+struct GroupPattern {
+    const char* regex;
+    InformationType type;
+    uint8_t classes;
+    uint8_t minLength;
+    uint8_t maxLength;
+};
+
 // This array contains all of the regex clauses used to decode the METAR information
 // Must be updated if the METAR standard changes or bugs are found
-constexpr std::pair<const char*, InformationType> regexToToken[] = {
-    {"(ILZM)|(ILZD)|(IL[A-Z]{2}|EF[A-Z]{2})", I_STATION},
-    {"[0-9]{2}([0-9]{4})Z", I_TIME},
-    {"NIL", I_NIL},
-    {"AUTO", I_AUTO},
-    {"(?:((?:\\\\\\/){5})|(00000)|(?:(VRB)|([0-9]{3}))([0-9]{2})(?:G([0-9]{2}))?)KT", I_WIND},
-    {"([0-9]{3})V([0-9]{3})", I_VARIABLE},
-    {"CAVOK", I_CAVOK},
-    {"((?:\\\\\\/){4})|([0-9]{4})", I_VISIBILITY},
-    {"R([0-9]{2})\\\\\\/(?:(M)|(P))?([0-9]{4})(?:(U)|(D)|(N))?", I_RVR},
-    {"(?:((?:\\\\\\/){6})|(?:(FEW)|(SCT)|(BKN)|(OVC))([0-9]{3}))(?:(CB)|(TCU))?", I_CLOUD},
-    {"NSC", I_NSC},
-    {"NCD", I_NCD},
-    {"VV([0-9]{3})", I_VERTICAL},
-    {"(?:(M)?([0-9]{2})|((?:\\\\\\/){2}))\\\\\\/(?:(M)?([0-9]{2})|((?:\\\\\\/){2}))", I_TEMPERATURE},
-    {"Q(?:([0-9]{4})|((?:\\\\\\/){4}))", I_QNH},
-    {"WS", I_WINDSHEAR},
-    {"ALL", I_ALL},
-    {"RWY", I_RWY},
-    {"R([0-9]{2})", I_RUNWAY_NUMBER},
-    {"((?:\\\\\\/){2})|(\\+)?(-)?((?:[A-Z]{2}){1,3})", I_WEATHER},
+constexpr GroupPattern regexToToken[] = {
+    {"(ILZM)|(ILZD)|(IL[A-Z]{2}|EF[A-Z]{2})", I_STATION, G_LETTER, 4, 4},
+    {"[0-9]{2}([0-9]{4})Z", I_TIME, G_DIGIT | G_LETTER, 7, 7},
+    {"NIL", I_NIL, G_LETTER, 3, 3},
+    {"AUTO", I_AUTO, G_LETTER, 4, 4},
+    {"(?:((?:\\\\\\/){5})|(00000)|(?:(VRB)|([0-9]{3}))([0-9]{2})(?:G([0-9]{2}))?)KT", I_WIND, G_DIGIT | G_LETTER | G_SLASH, 7, 12},
+    {"([0-9]{3})V([0-9]{3})", I_VARIABLE, G_DIGIT | G_LETTER, 7, 7},
+    {"CAVOK", I_CAVOK, G_LETTER, 5, 5},
+    {"((?:\\\\\\/){4})|([0-9]{4})", I_VISIBILITY, G_DIGIT | G_SLASH, 4, 8},
+    {"R([0-9]{2})\\\\\\/(?:(M)|(P))?([0-9]{4})(?:(U)|(D)|(N))?", I_RVR, G_DIGIT | G_LETTER | G_SLASH, 9, 11},
+    {"(?:((?:\\\\\\/){6})|(?:(FEW)|(SCT)|(BKN)|(OVC))([0-9]{3}))(?:(CB)|(TCU))?", I_CLOUD, G_DIGIT | G_LETTER | G_SLASH, 6, 15},
+    {"NSC", I_NSC, G_LETTER, 3, 3},
+    {"NCD", I_NCD, G_LETTER, 3, 3},
+    {"VV([0-9]{3})", I_VERTICAL, G_DIGIT | G_LETTER, 5, 5},
+    {"(?:(M)?([0-9]{2})|((?:\\\\\\/){2}))\\\\\\/(?:(M)?([0-9]{2})|((?:\\\\\\/){2}))", I_TEMPERATURE, G_DIGIT | G_LETTER | G_SLASH, 6, 10},
+    {"Q(?:([0-9]{4})|((?:\\\\\\/){4}))", I_QNH, G_DIGIT | G_LETTER | G_SLASH, 5, 9},
+    {"WS", I_WINDSHEAR, G_LETTER, 2, 2},
+    {"ALL", I_ALL, G_LETTER, 3, 3},
+    {"RWY", I_RWY, G_LETTER, 3, 3},
+    {"R([0-9]{2})", I_RUNWAY_NUMBER, G_DIGIT | G_LETTER, 3, 3},
+    {"((?:\\\\\\/){2})|(\\+)?(-)?((?:[A-Z]{2}){1,3})", I_WEATHER, G_LETTER | G_SIGN | G_SLASH, 2, 8},
 };
 
 // This array contains all of the possible weather types for the I_WEATHER information type
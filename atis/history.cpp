@@ -0,0 +1,227 @@
+/**
+ * ATIS METAR history program file.
+ * This file contains the logic to keep an append-only log of past METAR reports on the SD card.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "history.h"
+
+void recordGroup(MetarRecord& record, std::cmatch& match, InformationType type){
+    switch(type){
+        case I_STATION:
+            strncpy(record.station, Match(0), 4);
+            break;
+
+        case I_TIME: {
+            const char* time = Match(0);
+            int day = (time[0]-'0')*10 + (time[1]-'0');
+            int hour = (time[2]-'0')*10 + (time[3]-'0');
+            int minute = (time[4]-'0')*10 + (time[5]-'0');
+            record.issued = (day*24 + hour)*60 + minute;
+            break;
+        }
+
+        case I_NIL:
+            record.flags |= R_NIL;
+            break;
+
+        case I_AUTO:
+            record.flags |= R_AUTO;
+            break;
+
+        case I_WIND:
+            if(Matched(1)) break;
+            if(Matched(2)){
+                record.windDirection = 0;
+                break;
+            }
+            if(Matched(3)) record.windDirection = R_VARIABLE;
+            if(Matched(4)) record.windDirection = atoi(Match(4));
+            if(Matched(5)) record.windSpeed = atoi(Match(5));
+            if(Matched(6)) record.windGust = atoi(Match(6));
+            break;
+
+        case I_CAVOK:
+            record.flags |= R_CAVOK;
+            break;
+
+        case I_VISIBILITY:
+            // Only the prevailing visibility is recorded
+            if(Matched(2) && record.visibility == R_UNKNOWN) record.visibility = atoi(Match(2));
+            break;
+
+        case I_WEATHER: {
+            if(!Matched(4)) break;
+            const char* weather = Match(4);
+            int len = sizeof(weatherType)/sizeof(int);
+            int free = 0;
+            while(free < 4 && record.weather[free] != 0) free++;
+
+            for(int i=0; 2*i<Matched(4) && free<4; i++){
+                const int value = weather[2*i] | (weather[2*i+1] << 8);
+                int weather_index = std::find(weatherType, weatherType+len, value) - weatherType;
+                if(weather_index >= len) continue;
+                record.weather[free++] = (weather_index+1) | (Matched(2) ? 0x40 : 0) | (Matched(3) ? 0x80 : 0);
+            }
+            break;
+        }
+
+        case I_CLOUD:
+        case I_VERTICAL: {
+            int free = 0;
+            while(free < 3 && record.clouds[free] != 0) free++;
+            if(free >= 3) break;
+
+            if(type == I_VERTICAL){
+                record.clouds[free] = (R_VERTICAL << 13) | atoi(Match(1));
+                break;
+            }
+            if(!Matched(6)) break;
+            int cover = Matched(2) ? R_FEW : Matched(3) ? R_SCATTERED : Matched(4) ? R_BROKEN : R_OVERCAST;
+            record.clouds[free] = (cover << 13) | (Matched(7) ? 0x1000 : 0) | (Matched(8) ? 0x0800 : 0) | atoi(Match(6));
+            break;
+        }
+
+        case I_NSC:
+            record.flags |= R_NSC;
+            break;
+
+        case I_NCD:
+            record.flags |= R_NCD;
+            break;
+
+        case I_TEMPERATURE:
+            if(Matched(2)) record.temperature = (Matched(1) ? -1 : 1) * atoi(Match(2));
+            if(Matched(5)) record.dewpoint = (Matched(4) ? -1 : 1) * atoi(Match(5));
+            break;
+
+        case I_QNH:
+            if(Matched(1)) record.qnh = atoi(Match(1));
+            break;
+
+        default:
+            break;
+    }
+}
+
+void buildRecord(MetarRecord& record, char** metar, int size_metar, uint32_t time){
+    memset(&record, 0, sizeof(record));
+    record.time = time;
+    record.windDirection = R_UNKNOWN;
+    record.visibility = R_UNKNOWN;
+    record.temperature = R_UNKNOWN_TEMPERATURE;
+    record.dewpoint = R_UNKNOWN_TEMPERATURE;
+    record.letter = getCurrentLetter() - ALPHA;
+
+    for(int i=0; i<size_metar; i++){
+        std::cmatch match;
+        InformationType type = classifyGroup(metar[i], match);
+        recordGroup(record, match, type);
+    }
+}
+
+// Brings the index up to date with a log of `count` records
+void updateIndex(uint32_t count){
+    File index = SD.open(PATH_HISTORY_INDEX, FILE_WRITE);
+    if(!index) return;
+
+    // Every stride that has been started has an entry. An entry cut short by a power loss is cut off,
+    // and entries that were never written are read from the log
+    uint32_t strides = (count + HISTORY_STRIDE - 1) / HISTORY_STRIDE;
+    uint32_t entries = min((uint32_t)(index.size() / sizeof(uint32_t)), strides);
+    if(index.size() != entries * sizeof(uint32_t)) index.truncate(entries * sizeof(uint32_t));
+    if(entries < strides){
+        File log = SD.open(PATH_HISTORY, FILE_READ);
+        for(; log && entries < strides; entries++){
+            uint32_t time = 0;
+            log.seek(entries * HISTORY_STRIDE * sizeof(MetarRecord));
+            log.read((uint8_t*)&time, sizeof(uint32_t));
+            index.write((const uint8_t*)&time, sizeof(uint32_t));
+        }
+        log.close();
+    }
+    index.close();
+}
+
+bool appendRecord(const MetarRecord& record){
+    File log = SD.open(PATH_HISTORY, FILE_WRITE);
+    if(!log) return false;
+
+    // FILE_WRITE always writes at the end of the file, so a record cut short by a power loss is cut off before appending
+    uint32_t count = log.size() / sizeof(MetarRecord);
+    if(log.size() != count * sizeof(MetarRecord)) log.truncate(count * sizeof(MetarRecord));
+    bool written = log.write((const uint8_t*)&record, sizeof(MetarRecord)) == sizeof(MetarRecord);
+    log.close();
+    if(written) updateIndex(count + 1);
+    return written;
+}
+
+bool findRecord(MetarRecord& record, uint32_t time){
+    File log = SD.open(PATH_HISTORY, FILE_READ);
+    if(!log) return false;
+    uint32_t count = log.size() / sizeof(MetarRecord);
+    uint32_t low = 0;
+    uint32_t high = count;
+
+    // Find the last stride starting at or before the time, so that only one stride of the log needs to be searched
+    File index = SD.open(PATH_HISTORY_INDEX, FILE_READ);
+    if(index){
+        uint32_t first = 0;
+        uint32_t last = min((uint32_t)(index.size() / sizeof(uint32_t)), (count + HISTORY_STRIDE - 1) / HISTORY_STRIDE);
+        while(first < last){
+            uint32_t middle = (first + last) / 2;
+            uint32_t start = 0;
+            index.seek(middle * sizeof(uint32_t));
+            index.read((uint8_t*)&start, sizeof(uint32_t));
+            if(start <= time) first = middle + 1;
+            else last = middle;
+        }
+        index.close();
+        if(first > 0){
+            low = (first - 1) * HISTORY_STRIDE;
+            high = min(count, (uint32_t)(first * HISTORY_STRIDE));
+        }
+    }
+
+    bool found = false;
+    while(low < high){
+        uint32_t middle = (low + high) / 2;
+        MetarRecord candidate;
+        log.seek(middle * sizeof(MetarRecord));
+        log.read((uint8_t*)&candidate, sizeof(MetarRecord));
+        if(candidate.time <= time){
+            record = candidate;
+            found = true;
+            low = middle + 1;
+        }else{
+            high = middle;
+        }
+    }
+    log.close();
+    return found;
+}
+
+int lastRecords(MetarRecord* records, int count){
+    File log = SD.open(PATH_HISTORY, FILE_READ);
+    if(!log) return 0;
+
+    uint32_t total = log.size() / sizeof(MetarRecord);
+    uint32_t first = total > (uint32_t)count ? total - count : 0;
+    log.seek(first * sizeof(MetarRecord));
+    int read = log.read((uint8_t*)records, (total - first) * sizeof(MetarRecord)) / sizeof(MetarRecord);
+    log.close();
+    return read;
+}
@@ -0,0 +1,109 @@
+/**
+ * ATIS METAR history header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_HISTORY
+#define ATIS_HISTORY
+
+#include <SD.h>
+#include <regex>
+
+#include "config.h"
+#include "helper.h"
+#include "parser.h"
+
+// Special values of the fields in a MetarRecord
+#define R_UNKNOWN 0xFFFF
+#define R_VARIABLE 0xFFFE
+#define R_UNKNOWN_TEMPERATURE INT8_MIN
+
+// Flags in a MetarRecord
+#define R_NIL 0x01
+#define R_AUTO 0x02
+#define R_CAVOK 0x04
+#define R_NSC 0x08
+#define R_NCD 0x10
+
+// Cloud cover values in a MetarRecord cloud layer
+#define R_FEW 1
+#define R_SCATTERED 2
+#define R_BROKEN 3
+#define R_OVERCAST 4
+#define R_VERTICAL 5
+
+// A compact fixed-size record of one METAR report, as stored in the history log
+// Must be kept in sync with tools/history.py
+struct MetarRecord {
+    uint32_t time;              // Unix time when the report was received
+    char station[4];
+    uint16_t issued;            // Minutes since the start of the month when the report was issued
+    uint16_t windDirection;     // Degrees, R_VARIABLE or R_UNKNOWN
+    uint8_t windSpeed;          // Knots
+    uint8_t windGust;           // Knots, or 0 if there are no gusts
+    uint16_t visibility;        // Meters, or R_UNKNOWN
+    int8_t temperature;         // Degrees Celsius, or R_UNKNOWN_TEMPERATURE
+    int8_t dewpoint;            // Degrees Celsius, or R_UNKNOWN_TEMPERATURE
+    uint16_t qnh;               // Hectopascals, or 0 if unknown
+    uint8_t letter;             // Information letter, 0 for ALPHA
+    uint8_t flags;              // R_NIL, R_AUTO, R_CAVOK, R_NSC and R_NCD
+    uint16_t clouds[3];         // Cover in bits 13-15, CB in bit 12, TCU in bit 11 and height in hundreds of feet in bits 0-9
+    uint8_t weather[4];         // Index in `weatherType` plus one in bits 0-5, heavy in bit 6 and light in bit 7
+};
+
+static_assert(sizeof(MetarRecord) == 32, "MetarRecord must be 32 bytes");
+
+/**
+ * @brief Fills in a record from the split METAR information output by `parseMetar()`.
+ * 
+ * @param[out] record The record to fill in, passed by reference
+ * @param[in] metar A pointer to an array of character pointers, containing the pointers to each piece of METAR information
+ * @param[in] size_metar The size of the `metar` array
+ * @param[in] time The Unix time when the report was received
+ */
+void buildRecord(MetarRecord& record, char** metar, int size_metar, uint32_t time);
+
+/**
+ * @brief Appends a record to the end of the history log on the SD card.
+ * Every `HISTORY_STRIDE`th record also has its time appended to the sparse time index.
+ * A record or index entry left incomplete by a power loss is removed first, and missing index entries are rebuilt.
+ * Records must be appended in order of time.
+ * 
+ * @param[in] record The record to append
+ * @return true if the record was written
+ */
+bool appendRecord(const MetarRecord& record);
+
+/**
+ * @brief Finds the report that was current at a given time, i.e. the last one received at or before it.
+ * The time index narrows the search down to one stride of records, which is then searched in the log.
+ * 
+ * @param[out] record The record to write, passed by reference
+ * @param[in] time The Unix time to look up
+ * @return true if a report was found
+ */
+bool findRecord(MetarRecord& record, uint32_t time);
+
+/**
+ * @brief Reads the most recent records from the history log.
+ * 
+ * @param[out] records An array of MetarRecord where the records will be written, oldest first
+ * @param[in] count The maximum number of records to read
+ * @return The number of records written to `records`
+ */
+int lastRecords(MetarRecord* records, int count);
+
+#endif
@@ -0,0 +1,332 @@
+/**
+ * ATIS streaming decompressor program file.
+ * This file contains a small DEFLATE decompressor for compressed HTTP responses, following RFC 1950-1952.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "inflate.h"
+
+static_assert((INFLATE_WINDOW & (INFLATE_WINDOW-1)) == 0, "INFLATE_WINDOW must be a power of two");
+
+// Base values and extra bits of the length and distance codes
+const uint16_t lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const uint8_t lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+const uint16_t distBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+const uint8_t distExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// The order in which the code length code lengths are stored in a dynamic block
+const uint8_t codeOrder[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// The longest step reads a 15-bit length code with 5 extra bits and a 15-bit distance code with 13 extra bits
+#define MAX_STEP_BITS 48
+
+Inflater::Inflater(void (*output)(uint8_t byte, void* context), void* context){
+    this->output = output;
+    this->context = context;
+    begin(E_DEFLATE);
+}
+
+void Inflater::begin(ContentEncoding encoding){
+    this->encoding = encoding;
+    state = S_HEADER;
+    error = false;
+    ending = false;
+    bitBuffer = 0;
+    bitCount = 0;
+    headerPart = H_FIXED;
+    headerPos = 0;
+    headerSkip = 0;
+    lastBlock = false;
+    windowPos = 0;
+}
+
+bool Inflater::write(uint8_t byte){
+    if(error) return false;
+    if(state == S_DONE) return true;
+    if(readHeader(byte)) return !error;
+
+    bitBuffer |= (uint64_t)byte << bitCount;
+    bitCount += 8;
+    while(!error && state != S_DONE && step());
+    return !error;
+}
+
+bool Inflater::finish(){
+    ending = true;
+    while(!error && state != S_DONE && step());
+    return !error && state == S_DONE;
+}
+
+bool Inflater::readHeader(uint8_t byte){
+    if(state != S_HEADER) return false;
+    headerPos++;
+
+    if(encoding == E_DEFLATE){
+        // Servers send either zlib or raw DEFLATE data for "deflate", so only a valid zlib header is skipped
+        if(headerPos == 1){
+            headerFirst = byte;
+            if((byte & 0x0F) == 8 && (byte >> 4) <= 7) return true;
+            state = S_BLOCK;
+            return false;
+        }
+        if(((headerFirst << 8) | byte) % 31 != 0 || (byte & 0x20)) error = true;
+        state = S_BLOCK;
+        return true;
+    }
+
+    switch(headerPart){
+        case H_FIXED:
+            if((headerPos == 1 && byte != 0x1F) || (headerPos == 2 && byte != 0x8B) || (headerPos == 3 && byte != 8)) error = true;
+            if(headerPos == 4) headerFlags = byte;
+            if(headerPos == 10) nextHeaderPart();
+            break;
+
+        case H_EXTRA_LENGTH:
+            headerSkip |= byte << (8 * (headerPos-1));
+            if(headerPos < 2) break;
+            headerPart = H_EXTRA;
+            if(headerSkip == 0) nextHeaderPart();
+            break;
+
+        case H_EXTRA:
+        case H_CRC:
+            if(--headerSkip == 0) nextHeaderPart();
+            break;
+
+        case H_NAME:
+        case H_COMMENT:
+            if(byte == 0) nextHeaderPart();
+            break;
+    }
+    return true;
+}
+
+void Inflater::nextHeaderPart(){
+    // The optional parts of a gzip header always appear in this order
+    headerPos = 0;
+    headerSkip = 0;
+    if(headerFlags & 0x04){
+        headerFlags &= ~0x04;
+        headerPart = H_EXTRA_LENGTH;
+    }else if(headerFlags & 0x08){
+        headerFlags &= ~0x08;
+        headerPart = H_NAME;
+    }else if(headerFlags & 0x10){
+        headerFlags &= ~0x10;
+        headerPart = H_COMMENT;
+    }else if(headerFlags & 0x02){
+        headerFlags &= ~0x02;
+        headerPart = H_CRC;
+        headerSkip = 2;
+    }else{
+        state = S_BLOCK;
+    }
+}
+
+bool Inflater::available(int count){
+    return bitCount >= count || ending;
+}
+
+uint32_t Inflater::bits(int count){
+    if(bitCount < count){
+        error = true;
+        return 0;
+    }
+
+    uint32_t value = bitBuffer & ((1ULL << count) - 1);
+    bitBuffer >>= count;
+    bitCount -= count;
+    return value;
+}
+
+int Inflater::decode(const uint16_t* counts, const uint16_t* symbols){
+    // Canonical Huffman codes of each length are consecutive, so the code can be decoded one bit at a time
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    for(int length=1; length<16; length++){
+        code |= bits(1);
+        if(error) return -1;
+        int count = counts[length];
+        if(code - first < count) return symbols[index + code - first];
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    error = true;
+    return -1;
+}
+
+bool Inflater::buildTable(uint16_t* counts, uint16_t* symbols, const uint8_t* lengths, int size_lengths){
+    memset(counts, 0, 16*sizeof(uint16_t));
+    for(int i=0; i<size_lengths; i++) counts[lengths[i]]++;
+
+    int left = 1;
+    for(int length=1; length<16; length++){
+        left = (left << 1) - counts[length];
+        if(left < 0) return false;
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for(int length=1; length<15; length++) offsets[length+1] = offsets[length] + counts[length];
+    for(int i=0; i<size_lengths; i++){
+        if(lengths[i] != 0) symbols[offsets[lengths[i]]++] = i;
+    }
+    counts[0] = 0;
+    return true;
+}
+
+void Inflater::emit(uint8_t byte){
+    window[windowPos % INFLATE_WINDOW] = byte;
+    windowPos++;
+    output(byte, context);
+}
+
+bool Inflater::step(){
+    switch(state){
+        case S_BLOCK: {
+            if(!available(3)) return false;
+            lastBlock = bits(1);
+            int type = bits(2);
+            if(type == 0){
+                // Stored blocks start at the next byte
+                bits(bitCount % 8);
+                state = S_STORED_LENGTH;
+            }else if(type == 1){
+                for(int i=0; i<288; i++) lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+                buildTable(litlenCounts, litlenSymbols, lengths, 288);
+                for(int i=0; i<30; i++) lengths[i] = 5;
+                buildTable(distCounts, distSymbols, lengths, 30);
+                state = S_CODES;
+            }else if(type == 2){
+                state = S_TABLE_COUNTS;
+            }else{
+                error = true;
+            }
+            return true;
+        }
+
+        case S_STORED_LENGTH: {
+            if(!available(32)) return false;
+            uint32_t length = bits(16);
+            uint32_t inverse = bits(16);
+            if((length ^ 0xFFFF) != inverse) error = true;
+            storedLeft = length;
+            state = S_STORED_DATA;
+            return true;
+        }
+
+        case S_STORED_DATA:
+            if(storedLeft == 0){
+                state = lastBlock ? S_DONE : S_BLOCK;
+                return true;
+            }
+            if(!available(8)) return false;
+            emit(bits(8));
+            storedLeft--;
+            return true;
+
+        case S_TABLE_COUNTS:
+            if(!available(14)) return false;
+            size_litlen = bits(5) + 257;
+            size_dist = bits(5) + 1;
+            size_codes = bits(4) + 4;
+            if(size_litlen > 286 || size_dist > 30) error = true;
+            memset(lengths, 0, 19);
+            size_lengths = 0;
+            state = S_TABLE_CODES;
+            return true;
+
+        case S_TABLE_CODES:
+            if(!available(3)) return false;
+            lengths[codeOrder[size_lengths++]] = bits(3);
+            if(size_lengths < size_codes) return true;
+
+            // The code length codes are decoded with the literal/length table until the real tables are built
+            if(!buildTable(litlenCounts, litlenSymbols, lengths, 19)) error = true;
+            size_lengths = 0;
+            state = S_TABLE_LENGTHS;
+            return true;
+
+        case S_TABLE_LENGTHS: {
+            if(!available(14)) return false;
+            int symbol = decode(litlenCounts, litlenSymbols);
+            if(symbol < 0) return true;
+            if(symbol < 16){
+                lengths[size_lengths++] = symbol;
+            }else{
+                int repeat = symbol == 16 ? 3 + bits(2) : symbol == 17 ? 3 + bits(3) : 11 + bits(7);
+                uint8_t length = 0;
+                if(symbol == 16){
+                    if(size_lengths == 0){
+                        error = true;
+                        return true;
+                    }
+                    length = lengths[size_lengths-1];
+                }
+                if(size_lengths + repeat > size_litlen + size_dist){
+                    error = true;
+                    return true;
+                }
+                while(repeat--) lengths[size_lengths++] = length;
+            }
+            if(size_lengths < size_litlen + size_dist) return true;
+
+            if(!buildTable(distCounts, distSymbols, lengths+size_litlen, size_dist)) error = true;
+            if(!buildTable(litlenCounts, litlenSymbols, lengths, size_litlen)) error = true;
+            state = S_CODES;
+            return true;
+        }
+
+        case S_CODES: {
+            if(!available(MAX_STEP_BITS)) return false;
+            // A stream that ends in the middle of a code must not emit what the missing bits would decode to
+            int symbol = decode(litlenCounts, litlenSymbols);
+            if(symbol < 0) return true;
+            if(symbol < 256){
+                emit(symbol);
+                return true;
+            }
+            if(symbol == 256){
+                state = lastBlock ? S_DONE : S_BLOCK;
+                return true;
+            }
+
+            symbol -= 257;
+            if(symbol >= 29){
+                error = true;
+                return true;
+            }
+            int length = lengthBase[symbol] + bits(lengthExtra[symbol]);
+            int code = decode(distCounts, distSymbols);
+            if(code < 0 || code >= 30){
+                error = true;
+                return true;
+            }
+            uint32_t distance = distBase[code] + bits(distExtra[code]);
+            if(error || distance > windowPos || distance > INFLATE_WINDOW){
+                error = true;
+                return true;
+            }
+            while(length--) emit(window[(windowPos - distance) % INFLATE_WINDOW]);
+            return true;
+        }
+
+        default:
+            return false;
+    }
+}
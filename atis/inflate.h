@@ -0,0 +1,135 @@
+/**
+ * ATIS streaming decompressor header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_INFLATE
+#define ATIS_INFLATE
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "helper.h"
+
+// This enum contains the supported HTTP content encodings
+enum ContentEncoding {
+    E_IDENTITY,
+    E_GZIP,
+    E_DEFLATE,
+};
+
+/**
+ * @brief A streaming DEFLATE decompressor for gzip and zlib encoded data.
+ * Compressed data is written into it one byte at a time, and each decompressed byte is passed to a callback as soon as it is known.
+ * Only the last `INFLATE_WINDOW` bytes of output are kept, so data that refers further back than that cannot be decompressed.
+ * Checksums in the trailers are not verified.
+ */
+class Inflater {
+    public:
+        /**
+         * @param[in] output A function that is called with each decompressed byte and `context`
+         * @param[in] context A pointer that is passed on to `output`
+         */
+        Inflater(void (*output)(uint8_t byte, void* context), void* context);
+
+        /**
+         * @brief Prepares to decompress a new stream.
+         * 
+         * @param[in] encoding The container format of the stream. E_DEFLATE accepts both zlib and raw DEFLATE data
+         */
+        void begin(ContentEncoding encoding);
+
+        /**
+         * @brief Writes one byte of compressed data and decompresses as much as possible.
+         * 
+         * @param[in] byte The byte to write
+         * @return false if the data is invalid
+         */
+        bool write(uint8_t byte);
+
+        /**
+         * @brief Decompresses whatever is left after the last byte has been written.
+         * 
+         * @return true if the stream was decompressed completely
+         */
+        bool finish();
+
+    private:
+        // This enum contains the parts of the stream that the decompressor can be in
+        enum State {
+            S_HEADER,
+            S_BLOCK,
+            S_STORED_LENGTH,
+            S_STORED_DATA,
+            S_TABLE_COUNTS,
+            S_TABLE_CODES,
+            S_TABLE_LENGTHS,
+            S_CODES,
+            S_DONE,
+        };
+
+        // This enum contains the parts of a gzip header
+        enum HeaderPart {
+            H_FIXED,
+            H_EXTRA_LENGTH,
+            H_EXTRA,
+            H_NAME,
+            H_COMMENT,
+            H_CRC,
+        };
+
+        bool readHeader(uint8_t byte);
+        void nextHeaderPart();
+        bool step();
+        bool available(int count);
+        uint32_t bits(int count);
+        int decode(const uint16_t* counts, const uint16_t* symbols);
+        bool buildTable(uint16_t* counts, uint16_t* symbols, const uint8_t* lengths, int size_lengths);
+        void emit(uint8_t byte);
+
+        void (*output)(uint8_t byte, void* context);
+        void* context;
+
+        ContentEncoding encoding;
+        State state;
+        bool error;
+        bool ending;
+        uint64_t bitBuffer;
+        int bitCount;
+
+        HeaderPart headerPart;
+        int headerPos;
+        int headerSkip;
+        uint8_t headerFirst;
+        uint8_t headerFlags;
+
+        bool lastBlock;
+        int storedLeft;
+        int size_litlen;            // Number of literal/length codes in a dynamic block
+        int size_dist;              // Number of distance codes in a dynamic block
+        int size_codes;             // Number of code length codes in a dynamic block
+        int size_lengths;           // Number of code lengths read so far
+        uint8_t lengths[320];
+        uint16_t litlenCounts[16];
+        uint16_t litlenSymbols[288];
+        uint16_t distCounts[16];
+        uint16_t distSymbols[30];
+
+        uint8_t window[INFLATE_WINDOW];
+        uint32_t windowPos;         // Total number of bytes output
+};
+
+#endif
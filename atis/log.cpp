@@ -0,0 +1,107 @@
+/**
+ * ATIS logging program file.
+ * This file contains the logic to buffer binary log records in RAM and write them to the serial port when idle.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "log.h"
+
+static_assert((SIZE_LOG & (SIZE_LOG-1)) == 0, "SIZE_LOG must be a power of two");
+static_assert(sizeof(logLevels) <= 256, "Log events must fit in a byte");
+static_assert(sizeof(tokenFilenames)/sizeof(tokenFilenames[0]) <= 256, "Tokens must fit in a byte");
+
+uint8_t logBuffer[SIZE_LOG];
+uint32_t logHead = 0;       // Position of the next byte to write to the serial port
+uint32_t logTail = 0;       // Position of the next byte to append
+uint32_t logDropped = 0;
+
+void logByte(uint8_t value){
+    logBuffer[logTail++ & (SIZE_LOG-1)] = value;
+}
+
+void logBytes(const void* data, int size){
+    for(int i=0; i<size; i++) logByte(((const uint8_t*)data)[i]);
+}
+
+bool logRecord(LogEvent event, int size){
+    // Sync byte, event and time
+    int total = 6 + size;
+    if(logDropped > 0 && SIZE_LOG - (logTail-logHead) >= (uint32_t)total + 10){
+        // Report dropped records once there is room again, so that the gap shows up in the log
+        uint32_t dropped = logDropped;
+        logDropped = 0;
+        logEvent(L_DROPPED, (int32_t)dropped);
+    }
+    if(SIZE_LOG - (logTail-logHead) < (uint32_t)total){
+        logDropped++;
+        return false;
+    }
+
+    uint32_t time = millis();
+    logByte(LOG_SYNC);
+    logByte(event);
+    logBytes(&time, 4);
+    return true;
+}
+
+int logSize(int32_t value){
+    return 4;
+}
+
+int logSize(const char* value){
+    return 1 + min(strlen(value), (size_t)255);
+}
+
+int logSize(LogTokens value){
+    return 1 + constrain(value.count, 0, 255);
+}
+
+void logArgument(int32_t value){
+    logBytes(&value, 4);
+}
+
+void logArgument(const char* value){
+    uint8_t length = min(strlen(value), (size_t)255);
+    logByte(length);
+    logBytes(value, length);
+}
+
+void logArgument(LogTokens value){
+    uint8_t length = constrain(value.count, 0, 255);
+    logByte(length);
+    for(int i=0; i<length; i++) logByte(value.tokens[i]);
+}
+
+void beginLog(unsigned long baud){
+    if(LOG_LEVEL == 0) return;
+    Serial.begin(baud);
+    LOG(START, LOG_VERSION);
+}
+
+bool flushLog(){
+    if(LOG_LEVEL == 0) return true;
+
+    // Only write what the transmit buffer takes right away, so that flushing never blocks
+    int space = Serial.availableForWrite();
+    while(space > 0 && logHead != logTail){
+        uint32_t start = logHead & (SIZE_LOG-1);
+        int chunk = min((uint32_t)space, min(logTail-logHead, SIZE_LOG-start));
+        Serial.write(logBuffer+start, chunk);
+        logHead += chunk;
+        space -= chunk;
+    }
+    return logHead == logTail;
+}
@@ -0,0 +1,154 @@
+/**
+ * ATIS logging header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_LOG
+#define ATIS_LOG
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "helper.h"
+
+// Log levels, from the most to the least important
+#define LEVEL_ERROR 1
+#define LEVEL_INFO 2
+#define LEVEL_DEBUG 3
+
+// This table contains all the events that can be logged, with their level, argument types and message
+// The argument types are i for an integer, s for a string and t for a list of tokens. Each argument replaces one {} in the message
+// Events must only be added at the end, as tools/log.py reads this table to decode the log
+#define LOG_EVENTS(X) \
+    X(START, LEVEL_INFO, "i", "ATIS started, log version {}") \
+    X(DROPPED, LEVEL_ERROR, "i", "{} log records dropped") \
+    X(SD_FAILED, LEVEL_ERROR, "", "SD initialisation failed") \
+    X(SD_READY, LEVEL_INFO, "", "SD initialised") \
+    X(LITTLEFS_FAILED, LEVEL_ERROR, "", "LittleFS initialisation failed") \
+    X(CONFIG, LEVEL_INFO, "ss", "{} in use: {}") \
+    X(WIFI_CONNECTED, LEVEL_INFO, "", "WiFi connected") \
+    X(HISTORY_FAILED, LEVEL_ERROR, "", "Could not write METAR history") \
+    X(NEW_METAR, LEVEL_INFO, "", "New METAR, regenerating phrase") \
+    X(FIRST_WORD, LEVEL_INFO, "i", "Time to first word: {} ms") \
+    X(BROADCAST, LEVEL_INFO, "si", "Broadcast {} in {} ms") \
+    X(REPEATED, LEVEL_INFO, "iiii", "Repeated broadcast {}: started {} ms late, decoder busy {}% of {} ms") \
+    X(LOOP_END, LEVEL_DEBUG, "", "End of loop") \
+    X(CONNECT_FAILED, LEVEL_ERROR, "s", "Could not connect to {}") \
+    X(INFLATE_FAILED, LEVEL_ERROR, "", "Invalid compressed data") \
+    X(HEDGING, LEVEL_INFO, "", "Request is slow, hedging") \
+    X(RETRYING, LEVEL_INFO, "", "Request is slow, retrying at the next endpoint") \
+    X(RECEIVED, LEVEL_INFO, "ii", "Received {} bytes with encoding {}") \
+    X(FETCH_TIME, LEVEL_INFO, "iii", "Fetch took {} ms, p50 {} ms, p99 {} ms") \
+    X(RESPONSE, LEVEL_DEBUG, "s", "Response: {}") \
+    X(REQUEST_FAILED, LEVEL_ERROR, "i", "Request failed with status {}") \
+    X(FETCH_FAILED, LEVEL_ERROR, "", "Error in HTTPS request") \
+    X(DECODED, LEVEL_INFO, "s", "Decoded: {}") \
+    X(PARSED, LEVEL_DEBUG, "i", "Parsed {} pieces of information") \
+    X(NEXT_POLL, LEVEL_INFO, "i", "Next poll in {} ms") \
+    X(PUSH_TOKEN, LEVEL_DEBUG, "t", "Pushing {}") \
+    X(SEARCH_MATCH, LEVEL_DEBUG, "s", "Searching match for {}") \
+    X(FOUND_MATCH, LEVEL_DEBUG, "si", "Found match for {} with type {}") \
+    X(PHRASE, LEVEL_INFO, "t", "Phrase: {}") \
+    X(SEGMENTS, LEVEL_INFO, "iii", "Reused {} groups, converted {} in {} us") \
+    X(CANCELLED, LEVEL_INFO, "i", "Cancelled in {} us") \
+    X(SPEAKER, LEVEL_DEBUG, "ii", "Speaker underruns: {}, overruns: {}") \
+    X(TOKENS_PLAYED, LEVEL_INFO, "iiiiiii", "Clips played: {} for {} tokens, SD underruns: {}, cache hits: {}/{}, decoder time: {} ms, lowest free heap: {} bytes") \
+    X(CACHING, LEVEL_INFO, "s", "Caching {}") \
+    X(EVICTING, LEVEL_INFO, "s", "Evicting {}") \
+    X(COMPOUNDS, LEVEL_INFO, "i", "Compound clips loaded: {}") \
+    X(BENCHMARK, LEVEL_INFO, "ss", "Benchmarking {} in format {}") \
+    X(BENCHMARK_CLIP, LEVEL_INFO, "siiiii", "{}: {} bytes, {} samples at {} Hz, {} us, {} bytes of heap") \
+    X(BENCHMARK_EMPTY, LEVEL_ERROR, "", "No clips decoded") \
+    X(BENCHMARK_SUMMARY, LEVEL_INFO, "iiiii", "Decoded {} clips, {} ms of audio, CPU time: {} ms per s of audio, read: {} bytes per s of audio, peak heap: {} bytes") \
+    X(BENCHMARK_TIMESCALE, LEVEL_INFO, "iiiii", "Time scale at {}%: {} us per s of audio, {} of {} samples out, {} bytes of heap") \
+    X(BENCHMARK_PARSER, LEVEL_INFO, "iiiii", "Parser: split {} KB/s, classify {} us and {} regexes per 10 groups, {} us and {} regexes without shapes")
+
+// This enum contains all the events that can be logged
+enum LogEvent {
+    #define X(name, level, arguments, message) L_##name,
+    LOG_EVENTS(X)
+    #undef X
+};
+
+// The level of each event, so that events above LOG_LEVEL are removed at compile time
+constexpr uint8_t logLevels[] = {
+    #define X(name, level, arguments, message) level,
+    LOG_EVENTS(X)
+    #undef X
+};
+
+// Every record starts with this byte, so that the decoder can find records in a stream that starts mid-record
+#define LOG_SYNC 0xA5
+#define LOG_VERSION 1
+
+// A list of tokens to log, such as a phrase. Each token is written as one byte
+struct LogTokens {
+    const TokenType* tokens;
+    int count;
+};
+
+/**
+ * @brief Logs an event if its level is at most LOG_LEVEL. Events above the level compile to nothing, and their arguments are not evaluated.
+ * Arguments must match the types of the event in LOG_EVENTS.
+ */
+#define LOG(event, ...) do{ if(logLevels[L_##event] <= LOG_LEVEL) logEvent(L_##event, ##__VA_ARGS__); }while(0)
+
+/**
+ * @brief Starts the serial port that the log is written to, if LOG_LEVEL is not 0.
+ * 
+ * @param[in] baud The baud rate of the serial port
+ */
+void beginLog(unsigned long baud);
+
+/**
+ * @brief Writes as much of the log buffer to the serial port as fits in its transmit buffer, without waiting.
+ * Should be called whenever the program is idle.
+ * 
+ * @return true if the log buffer is now empty
+ */
+bool flushLog();
+
+/**
+ * @brief Reserves space for a record in the log buffer and writes its header.
+ * If the record does not fit, it is dropped and counted, so that logging never waits for the serial port.
+ * 
+ * @param[in] event The event to log
+ * @param[in] size The size of the record's arguments in bytes
+ * @return true if the record fits and its arguments must be written
+ */
+bool logRecord(LogEvent event, int size);
+
+int logSize(int32_t value);
+int logSize(const char* value);
+int logSize(LogTokens value);
+void logArgument(int32_t value);
+void logArgument(const char* value);
+void logArgument(LogTokens value);
+
+/**
+ * @brief Appends a binary record of an event and its arguments to the log buffer.
+ * Integers are written as 4 bytes, and strings and token lists as a length byte followed by at most 255 bytes.
+ * 
+ * @param[in] event The event to log
+ * @param[in] arguments The arguments of the event
+ */
+template<typename... Arguments>
+void logEvent(LogEvent event, Arguments... arguments){
+    if(!logRecord(event, (0 + ... + logSize(arguments)))) return;
+    (logArgument(arguments), ...);
+}
+
+#endif
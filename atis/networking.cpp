@@ -19,29 +19,240 @@
 
 #include "networking.h"
 
-void getMetar(char* response, int size_response, const char* url){
-    std::unique_ptr<BearSSL::WiFiClientSecure> client(new BearSSL::WiFiClientSecure);
-    client->setInsecure();
-    HTTPClient https;
-    https.setReuse(false);
-
-    https.begin(*client, String(url));
-    int responseCode = https.GET();
-
-    if(responseCode <= 0){
-        D_println("Error in HTTPS request");
-        strncpy(response, "ERROR", size_response);
-        response[size_response-1] = '\0';
+unsigned long fetchTimes[SIZE_FETCH_HISTORY];
+int size_fetch_times = 0;
+int next_fetch_time = 0;
+
+int splitUrls(char** endpoints, int size_endpoints, char* urls){
+    int count = 0;
+    for(char* endpoint=strtok(urls, " "); endpoint!=NULL && count<size_endpoints; endpoint=strtok(NULL, " ")){
+        endpoints[count++] = endpoint;
+    }
+    return count;
+}
+
+bool startFetch(Fetch& fetch, const char* url, unsigned long timeout){
+    fetch.client = NULL;
+    fetch.inflater = NULL;
+    fetch.encoding = E_IDENTITY;
+    fetch.pos = 0;
+    fetch.line = 0;
+    fetch.status = 0;
+    fetch.received = 0;
+    fetch.body = false;
+    fetch.complete = false;
+    fetch.start = millis();
+
+    // Split the URL into its host, port and path
+    bool secure = strncmp(url, "https://", 8) == 0;
+    if(!secure && strncmp(url, "http://", 7) != 0) return false;
+    const char* host = url + (secure ? 8 : 7);
+    const char* path = strchr(host, '/');
+    if(path == NULL) path = "/";
+    int size_host = strcspn(host, ":/");
+    if(size_host >= SIZE_HOST) return false;
+    char hostname[SIZE_HOST];
+    strncpy(hostname, host, size_host);
+    hostname[size_host] = '\0';
+    uint16_t port = host[size_host] == ':' ? atoi(host+size_host+1) : (secure ? 443 : 80);
+
+    if(secure){
+        BearSSL::WiFiClientSecure* client = new BearSSL::WiFiClientSecure;
+        client->setInsecure();
+        fetch.client = client;
+    }else{
+        fetch.client = new WiFiClient;
+    }
+    fetch.client->setTimeout(timeout);
+
+    if(!fetch.client->connect(hostname, port)){
+        LOG(CONNECT_FAILED, hostname);
+        stopFetch(fetch);
+        return false;
+    }
+
+    // HTTP/1.0 avoids chunked encoding, so the body can be read straight off the connection
+    fetch.client->print("GET ");
+    fetch.client->print(path);
+    fetch.client->print(" HTTP/1.0\r\nHost: ");
+    fetch.client->print(hostname);
+    if(FETCH_COMPRESSION) fetch.client->print("\r\nAccept-Encoding: gzip, deflate");
+    fetch.client->print("\r\nConnection: close\r\n\r\n");
+    return true;
+}
+
+void appendBody(uint8_t byte, void* context){
+    Fetch* fetch = (Fetch*)context;
+    if(fetch->pos >= fetch->size_response-1){
+        fetch->complete = true;
         return;
     }
 
-    strncpy(response, https.getString().c_str(), size_response);
+    fetch->response[fetch->pos++] = byte;
+    fetch->response[fetch->pos] = '\0';
+    // The METAR can only have become complete with its closing quote
+    if(byte == '"') fetch->complete = hasMetar(fetch->response);
+}
+
+void readHeader(Fetch& fetch){
+    fetch.response[min(fetch.pos, fetch.size_response-1)] = '\0';
+
+    if(fetch.line == 0){
+        const char* code = strchr(fetch.response, ' ');
+        fetch.status = code == NULL ? 0 : atoi(code+1);
+    }else if(strncasecmp(fetch.response, "Content-Encoding:", 17) == 0){
+        if(strstr(fetch.response+17, "gzip") != NULL) fetch.encoding = E_GZIP;
+        if(strstr(fetch.response+17, "deflate") != NULL) fetch.encoding = E_DEFLATE;
+    }else if(fetch.pos == 0){
+        fetch.body = true;
+        if(fetch.encoding == E_IDENTITY) return;
+        fetch.inflater = new Inflater(appendBody, &fetch);
+        fetch.inflater->begin(fetch.encoding);
+    }
+}
+
+FetchState stepFetch(Fetch& fetch){
+    while(fetch.client->available() > 0){
+        int c = fetch.client->read();
+        if(c < 0) break;
+
+        if(fetch.body){
+            fetch.received++;
+            if(fetch.inflater == NULL){
+                appendBody(c, &fetch);
+            }else if(!fetch.inflater->write(c)){
+                LOG(INFLATE_FAILED);
+                return F_FAILED;
+            }
+            // Stop reading as soon as the METAR has arrived instead of waiting for the whole body
+            if(fetch.complete) return F_DONE;
+            continue;
+        }
+
+        // Headers are parsed one line at a time
+        if(c == '\r') continue;
+        if(c != '\n'){
+            if(fetch.pos < fetch.size_response-1) fetch.response[fetch.pos] = c;
+            fetch.pos++;
+            continue;
+        }
+        readHeader(fetch);
+        if(fetch.line == 0 && fetch.status != 200) return F_FAILED;
+        fetch.line++;
+        fetch.pos = 0;
+    }
+
+    if(fetch.client->connected()) return F_PENDING;
+    if(fetch.inflater != NULL) fetch.inflater->finish();
+    return fetch.body && fetch.pos > 0 ? F_DONE : F_FAILED;
+}
+
+void stopFetch(Fetch& fetch){
+    delete fetch.inflater;
+    fetch.inflater = NULL;
+    if(fetch.client == NULL) return;
+
+    fetch.client->stop();
+    delete fetch.client;
+    fetch.client = NULL;
+}
+
+void recordFetchTime(unsigned long time){
+    fetchTimes[next_fetch_time] = time;
+    next_fetch_time = (next_fetch_time+1) % SIZE_FETCH_HISTORY;
+    size_fetch_times = min(size_fetch_times+1, SIZE_FETCH_HISTORY);
+}
+
+unsigned long getFetchPercentile(int percentile){
+    if(size_fetch_times == 0) return 0;
+
+    unsigned long sorted[SIZE_FETCH_HISTORY];
+    memcpy(sorted, fetchTimes, size_fetch_times*sizeof(unsigned long));
+    std::sort(sorted, sorted+size_fetch_times);
+    return sorted[(size_fetch_times-1) * percentile / 100];
+}
+
+void getMetar(char* response, int size_response, const char* url){
+    char urls[SIZE_URL];
+    strncpy(urls, url, SIZE_URL);
+    urls[SIZE_URL-1] = '\0';
+    char* endpoints[SIZE_ENDPOINTS];
+    int size_endpoints = splitUrls(endpoints, SIZE_ENDPOINTS, urls);
+
+    char buffers[2][size_response];
+    Fetch fetches[2] = {};
+    for(int i=0; i<2; i++){
+        fetches[i].response = buffers[i];
+        fetches[i].size_response = size_response;
+    }
+
+    // Until enough fetches have been timed, a request counts as slow only after a fixed delay
+    unsigned long slowDelay = size_fetch_times < SIZE_FETCH_HISTORY/2 ? FETCH_HEDGE_DELAY : getFetchPercentile(FETCH_HEDGE_PERCENTILE);
+    unsigned long start = millis();
+    bool retried = false;
+    int next = 0;
+
+    strncpy(response, "ERROR", size_response);
     response[size_response-1] = '\0';
-    https.end();
-    client.reset();
 
-    D_println("Response:");
-    D_println(response);
+    while(size_endpoints > 0 && millis()-start < FETCH_DEADLINE){
+        int active = (fetches[0].client != NULL) + (fetches[1].client != NULL);
+        // A request is only slow once it has itself been open for long, not when an earlier one failed slowly
+        Fetch& open = fetches[0].client != NULL ? fetches[0] : fetches[1];
+        bool slow = active == 1 && !retried && millis()-open.start >= slowDelay;
+
+        if(active == 0 || slow){
+            const char* endpoint = endpoints[next % size_endpoints];
+            if(slow){
+                // Connecting blocks until the connection is made, and for https:// also until the TLS handshake is done.
+                // Only a plain HTTP request is quick enough to start next to the slow one, and only if there is memory for it
+                if(strncmp(endpoint, "http://", 7) == 0 && ESP.getMaxFreeBlockSize() >= FETCH_HEDGE_HEAP){
+                    LOG(HEDGING);
+                }else{
+                    LOG(RETRYING);
+                    stopFetch(fetches[0]);
+                    stopFetch(fetches[1]);
+                }
+                retried = true;
+            }
+
+            Fetch& fetch = fetches[0].client == NULL ? fetches[0] : fetches[1];
+            startFetch(fetch, endpoint, FETCH_DEADLINE - (millis()-start));
+            next++;
+        }
+
+        for(Fetch& fetch : fetches){
+            if(fetch.client == NULL) continue;
+
+            FetchState state = stepFetch(fetch);
+            if(state == F_PENDING) continue;
+            if(state == F_DONE){
+                strncpy(response, fetch.response, size_response);
+                recordFetchTime(millis()-start);
+                LOG(RECEIVED, fetch.received, fetch.encoding);
+                stopFetch(fetches[0]);
+                stopFetch(fetches[1]);
+
+                LOG(FETCH_TIME, millis()-start, getFetchPercentile(50), getFetchPercentile(99));
+                LOG(RESPONSE, response);
+                return;
+            }
+
+            LOG(REQUEST_FAILED, fetch.status);
+            stopFetch(fetch);
+        }
+        delay(1);
+    }
+
+    stopFetch(fetches[0]);
+    stopFetch(fetches[1]);
+    LOG(FETCH_FAILED);
+}
+
+bool hasMetar(const char* raw){
+    const char* begin = strstr(raw, "\"p1\":\"");
+    if(begin == NULL) return false;
+    return strchr(begin+6, '"') != NULL;
 }
 
 int decodeMetar(char* metar, int size_metar, char* raw, int size_raw){
@@ -63,28 +274,36 @@ int decodeMetar(char* metar, int size_metar, char* raw, int size_raw){
     int copied = end-begin-1;
     strncpy(metar, begin, copied);
     metar[copied] = '\0';
-    D_print("Decoded: ");
-    D_println(metar);
+    LOG(DECODED, metar);
     return copied+1;
 }
 
 int parseMetar(char** parsed, int size_parsed, char* metar, int size_metar){
-    // Split string on spaces
+    // Split string on spaces. Most characters are not spaces, so four of them are checked at a time:
+    // a byte of `word ^ spaces` is zero exactly where there is a space, and the expression below is nonzero if any byte is zero
+    const uint32_t spaces = 0x20202020;
     parsed[0] = metar;
     int j = 1;
-    for(int i=0; i<size_metar; i++){
+    int i = 0;
+    while(i < size_metar && j < size_parsed){
+        if(i+4 <= size_metar){
+            uint32_t word;
+            memcpy(&word, metar+i, 4);
+            word ^= spaces;
+            if(((word - 0x01010101) & ~word & 0x80808080) == 0){
+                i += 4;
+                continue;
+            }
+        }
+
         if(metar[i] == ' '){
             metar[i] = '\0';
             parsed[j] = metar + i + 1;
             j++;
         }
+        i++;
     }
 
-    D_print("Parsed: ");
-    for(int i=0; i<j; i++){
-        D_print(parsed[i]);
-        D_print("|");
-    }
-    D_println();
+    LOG(PARSED, j);
     return j;
 }
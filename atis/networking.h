@@ -20,21 +20,127 @@
 #define ATIS_NETWORKING
 
 #include <ESP8266WiFi.h>
-#include <ESP8266HTTPClient.h>
 #include <WiFiClientSecureBearSSL.h>
 
 #include "config.h"
 #include "helper.h"
+#include "log.h"
+#include "inflate.h"
+
+// This enum contains the states of a single HTTP request
+enum FetchState {
+    F_PENDING,
+    F_DONE,
+    F_FAILED,
+};
+
+// A single HTTP request that is in flight
+struct Fetch {
+    WiFiClient* client;
+    Inflater* inflater;     // Decompressor for the body, or NULL if it is not compressed
+    ContentEncoding encoding;
+    char* response;         // Buffer for the current header line and the body
+    int size_response;      // The size of `response`
+    int pos;                // Position in the current header line or in the body
+    int line;               // Number of header lines received
+    int status;             // HTTP status code
+    int received;           // Number of body bytes received over the network
+    bool body;              // Whether all headers have been received
+    bool complete;          // Whether the body contains the whole METAR or fills `response`
+    unsigned long start;    // When the request was started, in milliseconds
+};
+
+/**
+ * @brief Splits a list of URLs separated by spaces into individual URLs.
+ * 
+ * @param[out] endpoints A pointer to an array of character pointers, where the pointers to each URL will be written
+ * @param[in] size_endpoints The maximum size of `endpoints`
+ * @param[in] urls A pointer to a char array with the URLs. It will be modified
+ * @return The number of URLs written to `endpoints`
+ */
+int splitUrls(char** endpoints, int size_endpoints, char* urls);
+
+/**
+ * @brief Connects to a server and sends an HTTP GET request.
+ * 
+ * @param[out] fetch The request to start, passed by reference. Its `response` buffer and `size_response` must already be set
+ * @param[in] url A pointer to a char array with an http:// or https:// URL
+ * @param[in] timeout The maximum time in milliseconds to wait for the connection
+ * @return true if the request was sent
+ */
+bool startFetch(Fetch& fetch, const char* url, unsigned long timeout);
+
+/**
+ * @brief Appends one byte of the response body to the request's `response` buffer.
+ * Used directly for uncompressed bodies and as the decompressor's output for compressed ones.
+ * 
+ * @param[in] byte The byte to append
+ * @param[out] context A pointer to the Fetch that the byte belongs to
+ */
+void appendBody(uint8_t byte, void* context);
+
+/**
+ * @brief Processes one complete header line of a response, which is stored in the request's `response` buffer.
+ * 
+ * @param[out] fetch The request that the header belongs to, passed by reference
+ */
+void readHeader(Fetch& fetch);
+
+/**
+ * @brief Reads whatever has arrived for a request without waiting for more.
+ * Compressed bodies are decompressed as they arrive, so neither the compressed nor the decompressed body is stored in full.
+ * 
+ * @param[out] fetch The request to read, passed by reference
+ * @return F_DONE once the METAR has arrived or the server has closed the connection,
+ * F_FAILED if the request failed, and F_PENDING otherwise
+ */
+FetchState stepFetch(Fetch& fetch);
+
+/**
+ * @brief Closes the connection of a request and frees it.
+ * 
+ * @param[out] fetch The request to stop, passed by reference
+ */
+void stopFetch(Fetch& fetch);
+
+/**
+ * @brief Records the duration of a successful fetch for the hedging delay and statistics.
+ * 
+ * @param[in] time The duration of the fetch in milliseconds
+ */
+void recordFetchTime(unsigned long time);
+
+/**
+ * @brief Gets a percentile of the recently recorded fetch durations.
+ * 
+ * @param[in] percentile The percentile to get, between 0 and 100
+ * @return The fetch duration in milliseconds, or 0 if no fetches have been recorded
+ */
+unsigned long getFetchPercentile(int percentile);
 
 /**
  * @brief Downloads the METAR information from ilmailusaa.fi.
+ * The URL may contain several endpoints separated by spaces. If a request takes longer than usual,
+ * it is abandoned and retried at the next endpoint. Connecting blocks, and an https:// connection blocks
+ * for the whole TLS handshake, so the slow request is kept open next to the new one only when the next endpoint
+ * is plain http:// and there is memory for a second connection. Then whichever answers first is used.
+ * The whole download is bounded by `FETCH_DEADLINE`, and stops as soon as the METAR field has been received.
  * 
  * @param[out] response A pointer to a char array, where the raw JSON-formatted data from ilmailusaa.fi will be written
  * @param[in] size_response The maximum size of the `response` array
- * @param[in] url A pointer to a char array where the URL is located
+ * @param[in] url A pointer to a char array where the URLs are located
  */
 void getMetar(char* response, int size_response, const char* url);
 
+/**
+ * @brief Checks whether a (possibly partial) response already contains the complete METAR field.
+ * Used by `getMetar()` to stop reading as soon as the METAR has been received.
+ *
+ * @param[in] raw A pointer to a null-terminated char array with raw JSON-formatted data from ilmailusaa.fi
+ * @return true if `decodeMetar()` can extract the METAR from `raw`
+ */
+bool hasMetar(const char* raw);
+
 /**
  * @brief Decodes the raw METAR information obtained from `getMetar()`.
  *
@@ -53,7 +159,7 @@ int decodeMetar(char* metar, int size_metar, char* raw, int size_raw);
  * @param[in] size_parsed The maximum size of the `parsed` array
  * @param[in] metar A pointer to a char array containing the current decoded METAR information
  * @param[in] size_metar The size of the `metar` array
- * @return The number of characters written to `parsed`
+ * @return The number of pieces written to `parsed`. If there are more than `size_parsed` pieces, the last one contains the rest of the information
  */
 int parseMetar(char** parsed, int size_parsed, char* metar, int size_metar);
 
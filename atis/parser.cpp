@@ -19,6 +19,9 @@
 
 #include "parser.h"
 
+static_assert(SIZE_PHRASE <= 255, "Segment positions must fit in a byte");
+static_assert(SIZE_METAR <= 255, "Segment offsets must fit in a byte");
+
 TokenType informationLetter;
 int lastTime = 0;
 
@@ -28,7 +31,7 @@ void pushToken(TokenType* phrase, int size_phrase, int& pos, TokenType token){
         return;
     }
 
-    D_print("Pushing "); D_println(token);
+    LOG(PUSH_TOKEN, LogTokens{&token, 1});
     phrase[pos] = token;
     pos++;
 }
@@ -121,8 +124,11 @@ TokenType getInformationLetter(const char* time){
     return informationLetter;
 }
 
+TokenType getCurrentLetter(){
+    return informationLetter;
+}
+
 int convertToken(TokenType* phrase, int size_phrase, int pos, std::cmatch& match, InformationType type){
-    D_println("Converting");
     switch(type){
         case I_STATION:
             PushToken(THIS_IS);
@@ -312,29 +318,86 @@ int convertToken(TokenType* phrase, int size_phrase, int pos, std::cmatch& match
     return pos;
 }
 
-int generatePhrase(TokenType* phrase, int size_phrase, char** metar, int size_metar){
+uint8_t groupClasses(const char* group, int& length){
+    uint8_t classes = 0;
+    for(length=0; group[length]!='\0'; length++){
+        char c = group[length];
+        if(c >= '0' && c <= '9') classes |= G_DIGIT;
+        else if(c >= 'A' && c <= 'Z') classes |= G_LETTER;
+        else if(c == '/' || c == '\\') classes |= G_SLASH;
+        else if(c == '+' || c == '-') classes |= G_SIGN;
+        else classes |= G_OTHER;
+    }
+    return classes;
+}
+
+InformationType classifyGroup(const char* group, std::cmatch& match){
+    LOG(SEARCH_MATCH, group);
+    int length;
+    uint8_t classes = groupClasses(group, length);
+    for(const GroupPattern& it : regexToToken){
+        // Only clauses that the piece of information has the right shape for are compiled and tried
+        if((classes & ~it.classes) != 0 || length < it.minLength || length > it.maxLength) continue;
+        bool found = std::regex_match(group, match, std::regex(it.regex));
+        if(!found) continue;
+
+        LOG(FOUND_MATCH, group, it.type);
+        return it.type;
+    }
+    return I_ERROR;
+}
+
+uint32_t hashGroup(const char* group){
+    uint32_t hash = 2166136261u;
+    for(const char* c=group; *c!='\0'; c++) hash = (hash ^ (uint8_t)*c) * 16777619u;
+    return hash;
+}
+
+int generateGroup(TokenType* phrase, int size_phrase, int pos, const char* text, const char* group, Segment& segment){
+    std::cmatch match;
+    segment.hash = hashGroup(group);
+    segment.type = classifyGroup(group, match);
+    segment.start = pos;
+    segment.offset = group - text;
+    pos = convertToken(phrase, size_phrase, pos, match, segment.type);
+    segment.length = pos - segment.start;
+    return pos;
+}
+
+int reuseGroup(TokenType* phrase, int size_phrase, int pos, const char* text, const char* group, Segment& segment, const TokenType* previous, const char* previousText, const Segment* previousSegments, int size_previous){
+    // The hash only rules out most groups quickly, since different groups can share a hash
+    uint32_t hash = hashGroup(group);
+    for(int i=0; i<size_previous; i++){
+        const Segment& old = previousSegments[i];
+        if(old.hash != hash || old.type == I_TIME) continue;
+        if(strcmp(previousText+old.offset, group) != 0) continue;
+
+        segment = old;
+        segment.start = pos;
+        segment.offset = group - text;
+        segment.length = min((int)old.length, size_phrase-pos);
+        memcpy(phrase+pos, previous+old.start, segment.length*sizeof(TokenType));
+        return pos + segment.length;
+    }
+    return -1;
+}
+
+int generatePhrase(TokenType* phrase, int size_phrase, Segment* segments, char** metar, int size_metar, const TokenType* previous, const char* previousText, const Segment* previousSegments, int size_previous){
     int pos = 0;
+    int reused = 0;
+    uint32_t start = ESP.getCycleCount();
     for(int i=0; i<size_metar; i++){
-        InformationType type = I_ERROR;
-        std::cmatch match;
-        D_print("Searching match for "); D_println(metar[i]);
-        for(std::pair<const char*, InformationType> it : regexToToken){
-            bool found = std::regex_match(metar[i], match, std::regex(it.first));
-            if(!found) continue;
-
-            D_print("Found match for "); D_print(metar[i]); D_print(" with type "); D_println(it.second);
-            type = it.second;
-            break;
+        // The groups are split out of the report's text in place, so the first one starts where the text does
+        int next = reuseGroup(phrase, size_phrase, pos, metar[0], metar[i], segments[i], previous, previousText, previousSegments, size_previous);
+        if(next >= 0){
+            pos = next;
+            reused++;
+            continue;
         }
-
-        pos = convertToken(phrase, size_phrase, pos, match, type);
+        pos = generateGroup(phrase, size_phrase, pos, metar[0], metar[i], segments[i]);
     }
 
-    D_print("Phrase: ");
-    for(int i=0; i<pos; i++){
-        D_print(phrase[i]);
-        D_print(" ");
-    }
-    D_println();
+    LOG(PHRASE, LogTokens{phrase, pos});
+    LOG(SEGMENTS, reused, size_metar-reused, (ESP.getCycleCount()-start) / ESP.getCpuFreqMHz());
     return pos;
 }
@@ -22,6 +22,7 @@
 #include <regex>
 
 #include "helper.h"
+#include "log.h"
 
 /**
  * @brief Pushes a single token onto the phrase array, ensuring that it is not written outside the array's bounds.
@@ -106,16 +107,88 @@ int convertToken(TokenType* phrase, int size_phrase, int pos, std::cmatch& match
 */
 TokenType getInformationLetter(const char* time);
 
+/**
+ * @brief Gets the information letter of the most recently generated phrase without advancing it
+ * 
+ * @return The TokenType value for the current information letter
+*/
+TokenType getCurrentLetter();
+
+/**
+ * @brief Finds the shape of a single piece of METAR information, which decides the regex clauses that can match it.
+ * 
+ * @param[in] group A pointer to a char array containing one piece of METAR information
+ * @param[out] length The length of `group`, passed by reference
+ * @return The G_ character classes that occur in `group`
+ */
+uint8_t groupClasses(const char* group, int& length);
+
+/**
+ * @brief Finds the type of a single piece of METAR information by matching it against the regex clauses in `regexToToken`.
+ * Only the clauses whose shape fits the piece of information are tried, in order.
+ * 
+ * @param[in] group A pointer to a char array containing one piece of METAR information
+ * @param[out] match Regex match object, passed by reference. It will contain the matched parts of `group`
+ * @return The type of the information, or I_ERROR if no clause matches
+ */
+InformationType classifyGroup(const char* group, std::cmatch& match);
+
+/**
+ * @brief Calculates the hash used to find identical pieces of METAR information in consecutive reports.
+ * 
+ * @param[in] group A pointer to a char array containing one piece of METAR information
+ * @return The 32-bit FNV-1a hash of `group`
+ */
+uint32_t hashGroup(const char* group);
+
+/**
+ * @brief Classifies a single piece of METAR information and appends its speech tokens to the `phrase` array.
+ * This allows the phrase to be generated one group at a time, so that playback can start before the whole report is processed.
+ * 
+ * @param[out] phrase A TokenType array to write to
+ * @param[in] size_phrase The maximum size of `phrase`
+ * @param[in] pos Current position in the TokenType array
+ * @param[in] text A pointer to the char array with the report's text, which `parseMetar()` split `group` out of
+ * @param[in] group A pointer to a char array containing one piece of METAR information
+ * @param[out] segment The segment where the group's type and the position of its tokens will be written, passed by reference
+ * @return The new position in `phrase` after the group's tokens have been written
+ */
+int generateGroup(TokenType* phrase, int size_phrase, int pos, const char* text, const char* group, Segment& segment);
+
+/**
+ * @brief Appends the speech tokens of a piece of METAR information that is identical to one in the previous phrase, without classifying it again.
+ * The time is never reused, because converting it advances the information letter.
+ * 
+ * @param[out] phrase A TokenType array to write to
+ * @param[in] size_phrase The maximum size of `phrase`
+ * @param[in] pos Current position in the TokenType array
+ * @param[in] text A pointer to the char array with the report's text, which `parseMetar()` split `group` out of
+ * @param[in] group A pointer to a char array containing one piece of METAR information
+ * @param[out] segment The segment where the group's type and the position of its tokens will be written, passed by reference
+ * @param[in] previous A TokenType array with the previous phrase
+ * @param[in] previousText A pointer to the char array with the previous report's split text
+ * @param[in] previousSegments A Segment array with the boundaries of each piece of information in `previous`
+ * @param[in] size_previous The size of the `previousSegments` array
+ * @return The new position in `phrase`, or -1 if the previous phrase has no identical piece of information
+ */
+int reuseGroup(TokenType* phrase, int size_phrase, int pos, const char* text, const char* group, Segment& segment, const TokenType* previous, const char* previousText, const Segment* previousSegments, int size_previous);
+
 /**
  * @brief Transforms the split METAR information output by `parseMetar()` into a list of tokens to be played on the speaker based on the METAR standard.
  * The official METAR standard can be found at https://ilmailusaa.fi/pdf/Saahaitari_01-2021.pdf.
+ * Usually only a few pieces of information change between reports, so the tokens of unchanged pieces are copied from the previous phrase.
  * 
  * @param[out] phrase A TokenType array to write to
  * @param[in] size_phrase The maximum size of `phrase`
+ * @param[out] segments A Segment array with room for `size_metar` segments, where the boundaries of each piece of information in `phrase` will be written
  * @param[in] metar A pointer to an array of character pointers, containing the pointers to each piece of METAR information
  * @param[in] size_metar The size of the `metar` array
+ * @param[in] previous A TokenType array with the previous phrase, whose segments are reused where possible. It must not overlap `phrase`
+ * @param[in] previousText A pointer to the char array with the previous report's split text, or NULL if there is no previous phrase
+ * @param[in] previousSegments A Segment array with the boundaries of each piece of information in `previous`
+ * @param[in] size_previous The size of the `previousSegments` array, or 0 if there is no previous phrase
  * @return The number of tokens written to `phrase`
  */
-int generatePhrase(TokenType* phrase, int size_phrase, char** metar, int size_metar);
+int generatePhrase(TokenType* phrase, int size_phrase, Segment* segments, char** metar, int size_metar, const TokenType* previous, const char* previousText, const Segment* previousSegments, int size_previous);
 
 #endif
@@ -19,30 +19,204 @@
 
 #include "player.h"
 
-void playMp3(char* path){
-    D_print("Playing ");
-    AudioOutputI2SNoDAC* out = new AudioOutputI2SNoDAC();
-    AudioGeneratorMP3* aud = new AudioGeneratorMP3();
-    AudioFileSourceSD* clip = new AudioFileSourceSD(path);
-
-    D_print("Looping ");
-    aud->begin(clip, out);
-    while(aud->loop());
+AudioFileSourcePrefetch clips[2];
+AudioFileSourceLittleFS cached;
+PlaybackSession session = {};
+unsigned long decodeTime = 0;
+uint32_t lowestHeap = 0;
+int speechRate = 100;
+volatile CancelReason cancelReason = X_NONE;
+volatile unsigned long cancelTime = 0;
+
+void IRAM_ATTR cancelPlayback(CancelReason reason){
+    if(cancelReason == X_NONE) cancelTime = micros();
+    cancelReason = reason;
+}
+
+bool isCancelled(){
+    return cancelReason != X_NONE;
+}
+
+CancelReason getCancelReason(){
+    return cancelReason;
+}
+
+CancelReason clearCancel(){
+    CancelReason reason = cancelReason;
+    cancelReason = X_NONE;
+    return reason;
+}
+
+unsigned long getDecodeTime(){
+    return decodeTime;
+}
+
+void setSpeechRate(int rate){
+    speechRate = constrain(rate, 100, 200);
+}
+
+void playAudio(AudioGenerator* aud, AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink){
+    aud->begin(clip, sink);
+    while(true){
+        unsigned long start = micros();
+        bool running = aud->loop();
+        decodeTime += micros() - start;
+        lowestHeap = min(lowestHeap, ESP.getFreeHeap());
+        if(!running) break;
+
+        // Each loop decodes at most one frame, so checking here bounds how long a cancellation takes.
+        // The time-scaler then throws away its buffered samples instead of playing them out when it is stopped
+        if(cancelReason != X_NONE) break;
+
+        // Keep reading ahead while the decoder works, for both this clip and the next one
+        clip->loop();
+        if(next != NULL) next->fill();
+    }
     aud->stop();
+}
 
-    D_print("Deleting ");
+void playClip(AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink){
+    AudioGenerator* aud = createDecoder(getFormat());
+    playAudio(aud, clip, next, sink);
+    delete aud;
+}
 
-    delete clip;
+void playWav(AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink){
+    AudioGeneratorWAV* aud = new AudioGeneratorWAV();
+    playAudio(aud, clip, next, sink);
     delete aud;
-    delete out;
+}
+
+void findClip(Clip& clip, const TokenType* tokens, int count, char* voicepack){
+    const char* name;
+    clip.length = matchCompound(tokens, count, name);
+    if(clip.length > 0){
+        clipPath(clip.path, 100, name, voicepack);
+        clip.source = C_SD;
+        if(SD.exists(clip.path)) return;
+    }
 
-    D_println("Exiting");
+    clip.length = 1;
+    if(isCached(tokens[0])){
+        cachePath(clip.path, 100, tokens[0], voicepack);
+        clip.source = C_CACHE;
+        return;
+    }
+
+    clipPath(clip.path, 100, tokenFilenames[tokens[0]], voicepack);
+    clip.source = SD.exists(clip.path) ? C_SD : C_NONE;
 }
 
 void playToken(TokenType token, char* voicepack){
-    char path[100];
-    snprintf(path, 100, "/audio/%s/%s.mp3", voicepack, tokenFilenames[token]);
-    if(!SD.exists(path)) return;
+    playTokens(&token, 1, voicepack);
+}
+
+void playTokens(const TokenType* tokens, int count, char* voicepack){
+    if(count <= 0) return;
+    beginPlayback(voicepack);
+    continuePlayback(tokens, count, true);
+    endPlayback();
+}
+
+bool isSettled(const TokenType* tokens, int count, int pos, bool complete){
+    return complete || !extendsCompound(tokens+pos, count-pos);
+}
+
+void beginPlayback(char* voicepack){
+    session.voicepack = voicepack;
+    session.ready = false;
+    session.current = 0;
+    session.position = 0;
+    session.count = 0;
+    session.played = 0;
+    session.hits = 0;
+    session.underruns = 0;
+    session.firstClip = 0;
+    decodeTime = 0;
+    lowestHeap = ESP.getFreeHeap();
+
+    // The outputs are kept for the whole broadcast, so only the decoders are allocated for each clip
+    session.out = new AudioOutputSpeaker();
+    session.timescale = speechRate != 100 ? new AudioOutputTimeScale(session.out, speechRate, isCancelled) : NULL;
+    session.sink = session.timescale != NULL ? (AudioOutput*)session.timescale : session.out;
+}
+
+int continuePlayback(const TokenType* tokens, int count, bool complete){
+    Clip* found = session.found;
+    int& current = session.current;
+    int& i = session.position;
+    session.count = count;
+
+    if(!session.ready){
+        if(i >= count || cancelReason != X_NONE || !isSettled(tokens, count, i, complete)) return i;
+        findClip(found[current], tokens+i, count-i, session.voicepack);
+        // Nothing was read ahead for a clip found here, so fill its buffer before the decoder starts reading in small pieces
+        if(found[current].source == C_SD && clips[current].open(found[current].path)) while(clips[current].fill());
+        session.ready = true;
+    }
+
+    while(i < count && cancelReason == X_NONE){
+        // The clip after this one is only known once no more tokens can make it a longer compound clip,
+        // so wait for more tokens instead of playing this one without reading the next one ahead
+        int following = i + found[current].length;
+        if(!complete && (following >= count || !isSettled(tokens, count, following, complete))) break;
+
+        // Find and open the clip after this one, so that it can be read ahead while this one plays
+        AudioFileSourcePrefetch* next = NULL;
+        if(following < count){
+            findClip(found[1-current], tokens+following, count-following, session.voicepack);
+            if(found[1-current].source == C_SD && clips[1-current].open(found[1-current].path)) next = &clips[1-current];
+        }
+
+        if(session.firstClip == 0) session.firstClip = millis();
+        if(found[current].source == C_CACHE){
+            // Decoded clips are played straight from flash
+            if(cached.open(found[current].path)) playWav(&cached, next, session.sink);
+            cached.close();
+            session.hits++;
+        }else if(found[current].source == C_SD && clips[current].isOpen()){
+            playClip(&clips[current], next, session.sink);
+            session.underruns += clips[current].getUnderruns();
+        }
+        clips[current].close();
+        session.played++;
+        // The gap between clips is idle time, and writing out the log never waits for the serial port
+        flushLog();
+
+        i = following;
+        current = 1-current;
+        session.ready = i < count;
+    }
+    return i;
+}
+
+void endPlayback(){
+    // Close a clip that was opened ahead but not played
+    clips[session.current].close();
+    LOG(SPEAKER, session.out->getUnderruns(), session.out->getOverruns());
+    delete session.timescale;
+    delete session.out;
+    session.timescale = NULL;
+    session.out = NULL;
+    if(cancelReason != X_NONE) LOG(CANCELLED, micros()-cancelTime);
+    LOG(TOKENS_PLAYED, session.played, session.count, session.underruns, session.hits, session.played, decodeTime/1000, lowestHeap);
+}
+
+unsigned long getFirstClipTime(){
+    return session.firstClip;
+}
 
-    playMp3(path);
+int speakMetar(TokenType* phrase, int size_phrase, Segment* segments, char** parsed, int size_parsed, char* voicepack, unsigned long start){
+    // One playback session spans all groups, so the next clip is read ahead and compound clips match across groups
+    int pos = 0;
+    beginPlayback(voicepack);
+    for(int i=0; i<size_parsed; i++){
+        pos = generateGroup(phrase, size_phrase, pos, parsed[0], parsed[i], segments[i]);
+        // After a cancellation the rest of the phrase is still generated, so that it can be played again
+        if(getCancelReason() == X_NONE) continuePlayback(phrase, pos, false);
+    }
+    continuePlayback(phrase, pos, true);
+    endPlayback();
+    if(getFirstClipTime() != 0) LOG(FIRST_WORD, getFirstClipTime()-start);
+    return pos;
 }
@@ -20,18 +20,135 @@
 #define ATIS_PLAYER
 
 #include "AudioFileSourceSD.h"
-#include "AudioGeneratorMP3.h"
+#include "AudioFileSourceLittleFS.h"
+#include "AudioGeneratorWAV.h"
 #include "AudioOutputI2SNoDAC.h"
 #undef stack
 
 #include "helper.h"
+#include "log.h"
+#include "parser.h"
+#include "cache.h"
+#include "compound.h"
+#include "format.h"
+#include "prefetch.h"
+#include "speaker.h"
+#include "timescale.h"
+
+// This enum contains all the places where a clip can be played from
+enum ClipSource {
+    C_NONE,
+    C_SD,
+    C_CACHE,
+};
+
+// This enum contains all the reasons why playback can be cancelled
+enum CancelReason {
+    X_NONE,
+    X_BUTTON,
+};
+
+// A clip that speaks one or more tokens
+struct Clip {
+    ClipSource source;
+    int length;         // The number of tokens spoken by the clip
+    char path[100];
+};
+
+// The state of playback that is kept from one call of `continuePlayback()` to the next
+struct PlaybackSession {
+    AudioOutputSpeaker* out;
+    AudioOutputTimeScale* timescale;
+    AudioOutput* sink;          // The output that clips are played on, which is `timescale` when speech is sped up
+    char* voicepack;
+    Clip found[2];              // The clip to play next, and the one after it while it is read ahead
+    bool ready;                 // Whether `found[current]` has been found and opened
+    int current;
+    int position;               // The number of tokens played so far
+    int count;                  // The number of tokens given so far
+    int played;                 // The number of clips played so far
+    int hits;                   // The number of clips played from the cache
+    int underruns;
+    unsigned long firstClip;    // When the first clip started, in milliseconds, or 0
+};
+
+/**
+ * @brief Cancels playback: the clip that is playing stops at its next frame and its buffered samples are thrown away,
+ * and no more clips are played until `clearCancel()` is called. Safe to call from an interrupt.
+ * 
+ * @param[in] reason Why playback is cancelled
+ */
+void cancelPlayback(CancelReason reason);
+
+/**
+ * @brief Gets why playback was cancelled, without clearing the cancellation.
+ * 
+ * @return The reason playback was cancelled, or X_NONE if it was not
+ */
+CancelReason getCancelReason();
+
+/**
+ * @brief Clears the cancellation so that clips can be played again.
+ * 
+ * @return The reason playback had been cancelled, or X_NONE if it was not
+ */
+CancelReason clearCancel();
+
+/**
+ * @brief Gets the time spent in the decoder during the most recent playback session, to tell how busy playback keeps the CPU.
+ * 
+ * @return The decoder time in microseconds
+ */
+unsigned long getDecodeTime();
+
+/**
+ * @brief Sets the speed at which speech is played back.
+ * 
+ * @param[in] rate The playback rate in percent, between 100 and 200. Values outside the range are clamped
+ */
+void setSpeechRate(int rate);
+
+/**
+ * @brief Plays a single audio clip with the given decoder.
+ * While the clip is decoded, the rest of it and the beginning of the next clip are read ahead into RAM.
+ * The output is created by `beginPlayback()` once per broadcast, rather than for every clip.
+ * Playback stops early if it is cancelled with `cancelPlayback()`.
+ * 
+ * @param[in] aud A pointer to the decoder to play the clip with
+ * @param[in] clip A pointer to the opened audio source to play
+ * @param[in] next A pointer to the opened audio source that will be played next, or NULL if there is none
+ * @param[in] sink A pointer to the audio output to play the clip on
+ */
+void playAudio(AudioGenerator* aud, AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink);
+
+/**
+ * @brief Plays a single audio clip from the voicepack, in the format that the voicepack declares.
+ * 
+ * @param[in] clip A pointer to the opened audio source to play
+ * @param[in] next A pointer to the opened audio source that will be played next, or NULL if there is none
+ * @param[in] sink A pointer to the audio output to play the clip on
+ */
+void playClip(AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink);
+
+/**
+ * @brief Plays a single WAV audio clip, such as a token from the cache.
+ * 
+ * @param[in] clip A pointer to the opened audio source to play
+ * @param[in] next A pointer to the opened audio source that will be played next, or NULL if there is none
+ * @param[in] sink A pointer to the audio output to play the clip on
+ */
+void playWav(AudioFileSource* clip, AudioFileSourcePrefetch* next, AudioOutput* sink);
 
 /**
- * @brief Plays a single MP3 audio clip from program memory.
+ * @brief Finds the clip to play for the tokens at the start of a sequence.
+ * The longest matching compound clip is preferred, then a cached clip of the first token, then its file on the SD card.
  * 
- * @param[in] path A pointer to a char array containing the path of the audio file to play
+ * @param[out] clip The clip to fill in, passed by reference
+ * @param[in] tokens A TokenType array with the tokens still to be played
+ * @param[in] count The number of tokens in `tokens`
+ * @param[in] voicepack A pointer to a character array with the voicepack name
  */
-void playMp3(char* path);
+void findClip(Clip& clip, const TokenType* tokens, int count, char* voicepack);
 
 /**
  * @brief Plays the sound file of an individual token of speech.
@@ -42,4 +159,63 @@ void playMp3(char* path);
  */
 void playToken(TokenType token, char* voicepack);
 
+/**
+ * @brief Plays the sound files of a sequence of speech tokens in one playback session, see `beginPlayback()`.
+ * 
+ * @param[in] tokens A TokenType array with the tokens to play
+ * @param[in] count The number of tokens in `tokens`
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ */
+void playTokens(const TokenType* tokens, int count, char* voicepack);
+
+/**
+ * @brief Starts a playback session, which creates the outputs once for all the tokens played until `endPlayback()`.
+ * Each token's file is read ahead while the previous one is playing, also from one call of `continuePlayback()` to the next.
+ * Sequences of tokens with a compound clip in the voicepack are played as one clip, and
+ * tokens that are in the cache are played from flash instead of being decoded from the SD card.
+ * 
+ * @param[in] voicepack A pointer to a character array with the voicepack name, which must stay valid until `endPlayback()`
+ */
+void beginPlayback(char* voicepack);
+
+/**
+ * @brief Plays the tokens of a phrase that is still being generated, from where the previous call left off.
+ * A clip is only played once the clip after it is known, so the last tokens wait for the next call unless `complete` is set.
+ * If playback is cancelled, the remaining tokens are skipped.
+ * 
+ * @param[in] tokens A TokenType array with the phrase so far, which only grows between calls
+ * @param[in] count The number of tokens in `tokens`
+ * @param[in] complete Whether the phrase is complete, so that all of its tokens are played
+ * @return The number of tokens of `tokens` played so far
+ */
+int continuePlayback(const TokenType* tokens, int count, bool complete);
+
+/**
+ * @brief Ends the playback session and frees its outputs. The speaker's underruns and overruns are logged.
+ */
+void endPlayback();
+
+/**
+ * @brief Gets when the first clip of the most recent playback session started, to tell how long it took until speech was heard.
+ * 
+ * @return The time in milliseconds, as returned by `millis()`, or 0 if no clip was played
+ */
+unsigned long getFirstClipTime();
+
+/**
+ * @brief Converts the METAR information into speech tokens one piece at a time and plays them in one playback session while the rest is generated.
+ * The first words are therefore spoken before the rest of the report has been processed.
+ * If playback is cancelled, the rest of the phrase is generated without being played.
+ * 
+ * @param[out] phrase A TokenType array, where the speech tokens corresponding to the METAR information will be written
+ * @param[in] size_phrase The maximum size of `phrase`
+ * @param[out] segments A Segment array with room for `size_parsed` segments, where the boundaries of each piece of METAR information in `phrase` will be written
+ * @param[in] parsed A pointer to an array of character pointers, containing the pointers to each piece of METAR information
+ * @param[in] size_parsed The size of `parsed`
+ * @param[in] voicepack A pointer to a character array with the voicepack name
+ * @param[in] start The `millis()` value when the broadcast was requested, used to report the time to first word
+ * @return The number of tokens generated
+ */
+int speakMetar(TokenType* phrase, int size_phrase, Segment* segments, char** parsed, int size_parsed, char* voicepack, unsigned long start);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+/**
+ * ATIS poller program file.
+ * This file contains the logic to decide when to download new METAR information in the background.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "poller.h"
+
+char currentMetar[SIZE_METAR] = "";
+unsigned long nextPoll = 0;
+int retries = 0;
+
+bool isPollDue(){
+    return (long)(millis() - nextPoll) >= 0;
+}
+
+bool updateMetar(const char* metar){
+    if(strcmp(metar, "ERROR") == 0) return false;
+    if(strncmp(currentMetar, metar, SIZE_METAR) == 0) return false;
+
+    strncpy(currentMetar, metar, SIZE_METAR);
+    currentMetar[SIZE_METAR-1] = '\0';
+    return true;
+}
+
+void schedulePoll(bool changed, bool failed){
+    unsigned long now = millis();
+
+    if(failed){
+        unsigned long backoff = min((unsigned long)POLL_RETRY << min(retries, 10), (unsigned long)POLL_RETRY_MAX);
+        nextPoll = now + backoff + random(POLL_JITTER);
+        retries++;
+    }else if(changed){
+        // The change was seen at most one retry after the METAR was issued, so the next one is due one interval later
+        nextPoll = now + POLL_INTERVAL;
+        retries = 0;
+    }else{
+        // The next METAR has not been issued yet, so poll again soon
+        nextPoll = now + POLL_RETRY + random(POLL_JITTER);
+        retries = 0;
+    }
+
+    LOG(NEXT_POLL, nextPoll - now);
+}
@@ -0,0 +1,53 @@
+/**
+ * ATIS poller header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_POLLER
+#define ATIS_POLLER
+
+#include <Arduino.h>
+
+#include "config.h"
+#include "helper.h"
+#include "log.h"
+
+/**
+ * @brief Checks whether it is time to download a new METAR in the background.
+ * 
+ * @return true if the next scheduled poll is due
+ */
+bool isPollDue();
+
+/**
+ * @brief Compares a freshly decoded METAR with the one currently in use and stores it if it has changed.
+ * 
+ * @param[in] metar A pointer to a null-terminated char array with the decoded METAR information
+ * @return true if `metar` differs from the previous METAR and the phrase must be regenerated
+ */
+bool updateMetar(const char* metar);
+
+/**
+ * @brief Schedules the next poll based on the result of the last download.
+ * A changed METAR schedules the next poll one METAR issue interval later, so that polls stay aligned to the issue times.
+ * An unchanged METAR is polled again shortly, and failed downloads are retried with an exponential, jittered backoff.
+ * 
+ * @param[in] changed Whether the last download returned a new METAR
+ * @param[in] failed Whether the last download failed
+ */
+void schedulePoll(bool changed, bool failed);
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * ATIS prefetching audio source program file.
+ * This file contains an audio source that reads clips from the SD card ahead of playback.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "prefetch.h"
+
+AudioFileSourcePrefetch::AudioFileSourcePrefetch(){
+    head = 0;
+    filled = 0;
+    underruns = 0;
+    bytesRead = 0;
+}
+
+AudioFileSourcePrefetch::~AudioFileSourcePrefetch(){
+    close();
+}
+
+bool AudioFileSourcePrefetch::open(const char* filename){
+    close();
+    // Statistics are kept after closing, as some decoders close their source when they stop
+    underruns = 0;
+    bytesRead = 0;
+    return file.open(filename);
+}
+
+uint32_t AudioFileSourcePrefetch::read(void* data, uint32_t len){
+    uint8_t* out = (uint8_t*)data;
+    uint32_t copied = 0;
+
+    while(copied < len && filled > 0){
+        uint32_t chunk = min(len-copied, min(filled, (uint32_t)sizeof(buffer)-head));
+        memcpy(out+copied, buffer+head, chunk);
+        head = (head+chunk) % sizeof(buffer);
+        filled -= chunk;
+        copied += chunk;
+    }
+
+    if(copied < len && file.isOpen()){
+        // The buffer ran dry, so the decoder has to wait for the SD card
+        uint32_t read = file.read(out+copied, len-copied);
+        if(read > 0) underruns++;
+        bytesRead += read;
+        copied += read;
+    }
+
+    return copied;
+}
+
+bool AudioFileSourcePrefetch::fill(){
+    if(!file.isOpen() || sizeof(buffer)-filled < SIZE_SECTOR) return false;
+
+    // A read stops at the end of the buffer and continues from its start on the next call
+    uint32_t tail = (head+filled) % sizeof(buffer);
+    uint32_t read = file.read(buffer+tail, min((uint32_t)SIZE_SECTOR, (uint32_t)sizeof(buffer)-tail));
+    filled += read;
+    bytesRead += read;
+    return read > 0;
+}
+
+bool AudioFileSourcePrefetch::seek(int32_t pos, int dir){
+    if(dir == SEEK_CUR){
+        pos += getPos();
+        dir = SEEK_SET;
+    }
+    head = 0;
+    filled = 0;
+    return file.seek(pos, dir);
+}
+
+bool AudioFileSourcePrefetch::close(){
+    head = 0;
+    filled = 0;
+    return file.isOpen() ? file.close() : true;
+}
+
+bool AudioFileSourcePrefetch::isOpen(){
+    return file.isOpen();
+}
+
+uint32_t AudioFileSourcePrefetch::getSize(){
+    return file.getSize();
+}
+
+uint32_t AudioFileSourcePrefetch::getPos(){
+    return file.getPos() - filled;
+}
+
+bool AudioFileSourcePrefetch::loop(){
+    fill();
+    return true;
+}
+
+int AudioFileSourcePrefetch::getUnderruns(){
+    return underruns;
+}
+
+uint32_t AudioFileSourcePrefetch::getBytesRead(){
+    return bytesRead;
+}
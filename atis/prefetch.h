@@ -0,0 +1,76 @@
+/**
+ * ATIS prefetching audio source header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_PREFETCH
+#define ATIS_PREFETCH
+
+#include "AudioFileSourceSD.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+
+/**
+ * @brief An audio source that reads an SD card file through a ring buffer of whole SD sectors.
+ * The buffer can be filled ahead of time with `fill()`, so that the beginning of a clip is already in RAM when it starts playing.
+ */
+class AudioFileSourcePrefetch : public AudioFileSource {
+    public:
+        AudioFileSourcePrefetch();
+        virtual ~AudioFileSourcePrefetch() override;
+
+        virtual bool open(const char* filename) override;
+        virtual uint32_t read(void* data, uint32_t len) override;
+        virtual bool seek(int32_t pos, int dir) override;
+        virtual bool close() override;
+        virtual bool isOpen() override;
+        virtual uint32_t getSize() override;
+        virtual uint32_t getPos() override;
+        virtual bool loop() override;
+
+        /**
+         * @brief Reads one sector from the SD card into the ring buffer if there is space for it.
+         * 
+         * @return true if data was read
+         */
+        bool fill();
+
+        /**
+         * @brief Gets the number of reads that could not be served from the ring buffer and had to wait for the SD card.
+         * 
+         * @return The number of underruns since the file was opened
+         */
+        int getUnderruns();
+
+        /**
+         * @brief Gets the number of bytes read from the SD card, both ahead of time and on underruns.
+         * 
+         * @return The number of bytes read since the file was opened
+         */
+        uint32_t getBytesRead();
+
+    private:
+        AudioFileSourceSD file;
+        uint8_t buffer[PREFETCH_SECTORS*SIZE_SECTOR];
+        uint32_t head;      // Position of the next byte to read in `buffer`
+        uint32_t filled;    // Number of unread bytes in `buffer`
+        int underruns;
+        uint32_t bytesRead;
+};
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * ATIS speaker output program file.
+ * This file contains the speaker output with counters of how smoothly samples reach it.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <i2s.h>
+
+#include "speaker.h"
+
+AudioOutputSpeaker::AudioOutputSpeaker(){
+    playing = false;
+    underruns = 0;
+    overruns = 0;
+}
+
+bool AudioOutputSpeaker::begin(){
+    // The decoder begins the output for every clip, and the buffers may run empty between clips
+    playing = false;
+    return AudioOutputI2SNoDAC::begin();
+}
+
+bool AudioOutputSpeaker::ConsumeSample(int16_t sample[2]){
+    // The DMA buffers only run empty during a clip if the decoder fell behind
+    if(playing && i2s_is_empty()) underruns++;
+
+    if(!AudioOutputI2SNoDAC::ConsumeSample(sample)){
+        overruns++;
+        return false;
+    }
+    playing = true;
+    return true;
+}
+
+int AudioOutputSpeaker::getUnderruns(){
+    return underruns;
+}
+
+int AudioOutputSpeaker::getOverruns(){
+    return overruns;
+}
@@ -0,0 +1,57 @@
+/**
+ * ATIS speaker output header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_SPEAKER
+#define ATIS_SPEAKER
+
+#include "AudioOutputI2SNoDAC.h"
+#undef stack
+
+/**
+ * @brief The speaker output, which counts how often the decoder and the I2S DMA buffers had to wait for each other.
+ * An underrun is a sample that arrives after the DMA buffers ran empty in the middle of a clip, which is heard as a gap.
+ * An overrun is a sample that the full DMA buffers refused, which only makes the decoder wait until there is room.
+ */
+class AudioOutputSpeaker : public AudioOutputI2SNoDAC {
+    public:
+        AudioOutputSpeaker();
+
+        virtual bool begin() override;
+        virtual bool ConsumeSample(int16_t sample[2]) override;
+
+        /**
+         * @brief Gets the number of times the speaker ran out of samples while a clip was playing.
+         * 
+         * @return The number of underruns since the output was created
+         */
+        int getUnderruns();
+
+        /**
+         * @brief Gets the number of samples that were refused because the speaker's buffers were full.
+         * 
+         * @return The number of overruns since the output was created
+         */
+        int getOverruns();
+
+    private:
+        bool playing;   // Whether a sample of the current clip has been accepted, after which the buffers should never run empty
+        int underruns;
+        int overruns;
+};
+
+#endif
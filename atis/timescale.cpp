@@ -0,0 +1,156 @@
+/**
+ * ATIS time-scale modification program file.
+ * This file contains the logic to play speech faster without changing its pitch.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "timescale.h"
+
+AudioOutputTimeScale::AudioOutputTimeScale(AudioOutput* sink, int rate, bool (*cancelled)()) : sink(sink), cancelled(cancelled){
+    this->rate = constrain(rate, 100, 200);
+    filled = 0;
+    hasTail = false;
+    tailEnd = 0;
+    size_output = 0;
+    written = 0;
+    channels = 2;
+    resize(22050);
+}
+
+void AudioOutputTimeScale::resize(int hz){
+    // Segments of about 20 ms are long enough to contain a few pitch periods of speech
+    size_frame = constrain(hz / 50, 64, SIZE_TSM_FRAME);
+    size_overlap = size_frame / 4;
+    size_search = size_frame / 4;
+    advance = (size_frame - size_overlap) * rate / 100;
+}
+
+bool AudioOutputTimeScale::SetRate(int hz){
+    hertz = hz;
+    resize(hz);
+    return sink->SetRate(hz);
+}
+
+bool AudioOutputTimeScale::SetBitsPerSample(int bits){
+    // 8-bit samples are widened before they are mixed, so the sink always gets 16 bits
+    bps = bits;
+    return sink->SetBitsPerSample(16);
+}
+
+bool AudioOutputTimeScale::SetChannels(int channels){
+    this->channels = channels;
+    return sink->SetChannels(channels);
+}
+
+bool AudioOutputTimeScale::SetGain(float gain){
+    return sink->SetGain(gain);
+}
+
+bool AudioOutputTimeScale::begin(){
+    filled = 0;
+    hasTail = false;
+    tailEnd = 0;
+    size_output = 0;
+    written = 0;
+    return sink->begin();
+}
+
+bool AudioOutputTimeScale::writeOutput(){
+    for(; written<size_output; written++){
+        int16_t sample[2] = {output[written], output[written]};
+        if(!sink->ConsumeSample(sample)) return false;
+    }
+    size_output = 0;
+    written = 0;
+    return true;
+}
+
+bool AudioOutputTimeScale::ConsumeSample(int16_t sample[2]){
+    if(cancelled != NULL && cancelled()) return false;
+
+    // Hold the decoder back until the previous segment has been written out
+    if(!writeOutput()) return false;
+
+    int16_t stereo[2] = {sample[LEFTCHANNEL], sample[RIGHTCHANNEL]};
+    MakeSampleStereo16(stereo);
+    input[filled++] = channels == 1 ? stereo[LEFTCHANNEL] : (stereo[LEFTCHANNEL]>>1) + (stereo[RIGHTCHANNEL]>>1);
+    if(filled >= max(size_frame + size_search, advance)) process();
+    return true;
+}
+
+int AudioOutputTimeScale::findOffset(){
+    if(!hasTail) return 0;
+
+    // Every other sample is enough to find the best alignment, and halves the cost
+    int best = 0;
+    int32_t bestCorrelation = INT32_MIN;
+    for(int offset=0; offset<size_search; offset++){
+        int32_t correlation = 0;
+        for(int i=0; i<size_overlap; i+=2) correlation += (input[offset+i] >> 4) * (tail[i] >> 4);
+        if(correlation <= bestCorrelation) continue;
+        bestCorrelation = correlation;
+        best = offset;
+    }
+    return best;
+}
+
+void AudioOutputTimeScale::process(){
+    int offset = findOffset();
+    const int16_t* segment = input + offset;
+
+    // Crossfade the end of the previous segment into the start of this one
+    for(int i=0; i<size_overlap; i++){
+        if(!hasTail){
+            output[size_output++] = segment[i];
+            continue;
+        }
+        output[size_output++] = (tail[i] * (size_overlap-i) + segment[i] * i) / size_overlap;
+    }
+    for(int i=size_overlap; i<size_frame-size_overlap; i++) output[size_output++] = segment[i];
+
+    memcpy(tail, segment+size_frame-size_overlap, size_overlap*sizeof(int16_t));
+    hasTail = true;
+    tailEnd = offset + size_frame - advance;
+
+    filled -= advance;
+    memmove(input, input+advance, filled*sizeof(int16_t));
+}
+
+bool AudioOutputTimeScale::waitOutput(){
+    while(!writeOutput()){
+        if(cancelled != NULL && cancelled()) return false;
+        yield();
+    }
+    return true;
+}
+
+bool AudioOutputTimeScale::stop(){
+    if(!waitOutput()) return sink->stop();
+
+    // Play out the end of the last segment and the rest of the input as they are
+    if(hasTail){
+        memcpy(output, tail, size_overlap*sizeof(int16_t));
+        size_output = size_overlap;
+        if(!waitOutput()) return sink->stop();
+    }
+    for(int i=max(tailEnd, 0); i<filled; i+=SIZE_TSM_FRAME){
+        size_output = min(filled-i, SIZE_TSM_FRAME);
+        memcpy(output, input+i, size_output*sizeof(int16_t));
+        if(!waitOutput()) return sink->stop();
+    }
+
+    return sink->stop();
+}
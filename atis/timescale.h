@@ -0,0 +1,78 @@
+/**
+ * ATIS time-scale modification header file.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_TIMESCALE
+#define ATIS_TIMESCALE
+
+#include "AudioOutput.h"
+#undef stack
+
+#include "config.h"
+#include "helper.h"
+
+/**
+ * @brief An audio output that speeds up speech without changing its pitch before passing it on to another output.
+ * It uses synchronised overlap-add (SOLA) in fixed point: the input is cut into overlapping segments that are taken
+ * further apart than they are written out, and each segment is shifted to where it best matches the previous one before they are crossfaded.
+ * The output is mono and 16 bits.
+ */
+class AudioOutputTimeScale : public AudioOutput {
+    public:
+        /**
+         * @param[in] sink A pointer to the audio output that the time-scaled samples are written to
+         * @param[in] rate The playback rate in percent, for example 150 for 1.5x speed. Must be between 100 and 200
+         * @param[in] cancelled A pointer to a function that returns true once playback is cancelled, or NULL.
+         * After a cancellation, new samples are refused and `stop()` returns without playing out the buffered samples
+         */
+        AudioOutputTimeScale(AudioOutput* sink, int rate, bool (*cancelled)() = NULL);
+
+        virtual bool SetRate(int hz) override;
+        virtual bool SetBitsPerSample(int bits) override;
+        virtual bool SetChannels(int channels) override;
+        virtual bool SetGain(float gain) override;
+        virtual bool begin() override;
+        virtual bool ConsumeSample(int16_t sample[2]) override;
+        virtual bool stop() override;
+
+    private:
+        void resize(int hz);
+        bool writeOutput();
+        bool waitOutput();
+        int findOffset();
+        void process();
+
+        AudioOutput* sink;
+        bool (*cancelled)();
+        int rate;
+
+        int size_frame;         // Length of one segment
+        int size_overlap;       // Length of the crossfade between segments
+        int size_search;        // Number of offsets tried when aligning a segment
+        int advance;            // Number of input samples consumed per segment
+
+        int16_t input[2*SIZE_TSM_FRAME];
+        int filled;             // Number of samples in `input`
+        int16_t tail[SIZE_TSM_FRAME/4];
+        bool hasTail;           // Whether `tail` holds the end of the previous segment
+        int tailEnd;            // Position in `input` right after the samples in `tail`
+        int16_t output[SIZE_TSM_FRAME];
+        int size_output;        // Number of samples in `output`
+        int written;            // Number of samples in `output` already written to the sink
+};
+
+#endif
@@ -0,0 +1,234 @@
+/**
+ * ATIS broadcast test.
+ * This file speaks METAR reports of different lengths with a voicepack of short stand-in clips,
+ * and measures how long it takes from the start of a broadcast until the first word is heard,
+ * how often a slow SD card makes playback wait, and how many clips compound clips save.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "host.h"
+#include "networking.h"
+#include "player.h"
+
+#define RUNS 5
+#define CLIP_RATE 16000
+#define SLOW_TOKENS 12
+
+extern PlaybackSession session;
+
+char voicepack[] = "test";
+char slowVoicepack[] = "slow";
+int failed = 0;
+unsigned long sectorTime = 0;
+
+void check(bool passed, const char* name){
+    printf("%-24s %s\n", name, passed ? "ok" : "FAIL");
+    failed += !passed;
+}
+
+void writeClip(const char* path, int samples){
+    uint32_t size = 2*samples;
+    uint32_t header[11] = {
+        0x46464952, size+36, 0x45564157,                                // "RIFF", size, "WAVE"
+        0x20746D66, 16, 1 | (1 << 16), CLIP_RATE, 2*CLIP_RATE, 2 | (16 << 16), // "fmt ", PCM, mono, 16 bits
+        0x61746164, size,                                               // "data", size
+    };
+    File clip = SD.open(path, FILE_WRITE);
+    clip.write((const uint8_t*)header, sizeof(header));
+    for(uint32_t i=0; i<size; i++) clip.write(i);
+    clip.close();
+}
+
+void writeVoicepack(char* name, int samples){
+    char path[100];
+    snprintf(path, 100, "/audio/%s", name);
+    SD.mkdir(path);
+    snprintf(path, 100, "/audio/%s/format.txt", name);
+    File format = SD.open(path, FILE_WRITE);
+    format.write((const uint8_t*)"wav", 3);
+    format.close();
+    loadFormat(name);
+
+    for(int i=0; i<TOKEN_COUNT; i++){
+        clipPath(path, 100, tokenFilenames[i], name);
+        writeClip(path, samples);
+    }
+}
+
+// Compound clips, one of which spans the station name and the information letter
+const char manifest[] =
+    "EFHK_INFORMATION ECHO FOXTROT HOTEL KILO INFORMATION\n"
+    "KNOTS_GUSTING KNOTS GUSTING\n"
+    "THOUSAND_FEET THOUSAND FEET\n"
+    "ONE_ZERO ONE ZERO\n";
+
+void writeCompounds(){
+    File file = SD.open("/audio/test/compound.txt", FILE_WRITE);
+    file.write((const uint8_t*)manifest, sizeof(manifest)-1);
+    file.close();
+
+    char path[100];
+    for(const char* name : {"EFHK_INFORMATION", "KNOTS_GUSTING", "THOUSAND_FEET", "ONE_ZERO"}){
+        clipPath(path, 100, name, voicepack);
+        writeClip(path, CLIP_RATE/200);
+    }
+}
+
+/**
+ * @brief Speaks a report with the compound clips that are loaded and counts the clips played.
+ *
+ * @param[in] report A pointer to a char array with the report
+ * @param[out] expected The number of clips when the compound clips are matched on the whole phrase at once, passed by reference
+ * @return The number of clips played
+ */
+int countClips(const char* report, int& expected){
+    char metar[SIZE_METAR];
+    char* parsed[SIZE_PARSED];
+    TokenType phrase[SIZE_PHRASE];
+    Segment segments[SIZE_PARSED];
+    strncpy(metar, report, SIZE_METAR);
+    int size_parsed = parseMetar(parsed, SIZE_PARSED, metar, strlen(metar)+1);
+    int size_phrase = speakMetar(phrase, SIZE_PHRASE, segments, parsed, size_parsed, voicepack, millis());
+
+    expected = 0;
+    for(int i=0; i<size_phrase; expected++){
+        const char* name;
+        i += max(matchCompound(phrase+i, size_phrase-i, name), 1);
+    }
+    return session.played;
+}
+
+unsigned long slowSector(){
+    return sectorTime;
+}
+
+/**
+ * @brief Plays a few tokens from an SD card that takes a while to read each sector, and prints how often playback had to wait.
+ * The fewest underruns of a few runs are taken, so that the host scheduling a thread out does not count.
+ *
+ * @param[in] time How long reading a sector takes, in microseconds
+ * @return The number of times the decoder waited for the SD card or the speaker ran out of samples in the middle of a clip
+ */
+int playSlowly(unsigned long time){
+    TokenType tokens[SLOW_TOKENS];
+    for(int i=0; i<SLOW_TOKENS; i++) tokens[i] = TokenType(i);
+    sectorTime = time;
+    setSdLatency(slowSector);
+
+    int sd = INT_MAX;
+    int speaker = INT_MAX;
+    for(int i=0; i<3; i++){
+        beginPlayback(slowVoicepack);
+        continuePlayback(tokens, SLOW_TOKENS, true);
+        sd = min(sd, session.underruns);
+        speaker = min(speaker, session.out->getUnderruns());
+        endPlayback();
+    }
+    setSdLatency(NULL);
+
+    printf("%5.1f ms per sector: %3d SD underruns, %3d speaker underruns\n", time/1000.0, sd, speaker);
+    return sd + speaker;
+}
+
+
+/**
+ * @brief Speaks a report several times and prints the medians of the time to the first word
+ * and of the time that generating the whole phrase takes, which the first word used to wait for.
+ *
+ * @param[in] report A pointer to a char array with the report
+ * @return The median time from the start of the broadcast until the first sample was played, in microseconds
+ */
+unsigned long measure(const char* report){
+    unsigned long firstWord[RUNS];
+    unsigned long generated[RUNS];
+    int size_parsed = 0;
+    int size_phrase = 0;
+    for(int i=0; i<RUNS; i++){
+        char metar[SIZE_METAR];
+        char* parsed[SIZE_PARSED];
+        TokenType phrase[SIZE_PHRASE];
+        Segment segments[SIZE_PARSED];
+
+        strncpy(metar, report, SIZE_METAR);
+        size_parsed = parseMetar(parsed, SIZE_PARSED, metar, strlen(metar)+1);
+        unsigned long start = micros();
+        generatePhrase(phrase, SIZE_PHRASE, segments, parsed, size_parsed, NULL, NULL, NULL, 0);
+        generated[i] = micros() - start;
+
+        strncpy(metar, report, SIZE_METAR);
+        size_parsed = parseMetar(parsed, SIZE_PARSED, metar, strlen(metar)+1);
+        getFirstSample();
+        start = micros();
+        size_phrase = speakMetar(phrase, SIZE_PHRASE, segments, parsed, size_parsed, voicepack, millis());
+        firstWord[i] = getFirstSample() - start;
+    }
+
+    unsigned long p50 = percentile(firstWord, RUNS, 50);
+    printf("%2d groups, %3d tokens: first word p50 %5.2f ms, whole phrase generated p50 %5.2f ms\n",
+        size_parsed, size_phrase, p50/1000.0, percentile(generated, RUNS, 50)/1000.0);
+    return p50;
+}
+
+
+int main(){
+    char root[] = "/tmp/atis-broadcast-XXXXXX";
+    setFileRoot(mkdtemp(root));
+    // The clips of the slow voicepack are 100 ms long, so that each one spans several sectors
+    writeVoicepack(slowVoicepack, CLIP_RATE/10);
+    // The clips are 5 ms long, so that a whole broadcast plays quickly
+    writeVoicepack(voicepack, CLIP_RATE/200);
+
+    const char* reports[] = {
+        "EFHK 121250Z 24008KT CAVOK 18\\/09 Q1012",
+        "EFHK 121250Z AUTO 24008G18KT 210V280 9999 -SHRA FEW030CB BKN045 18\\/09 Q1012 NOSIG",
+        "EFHK 121250Z AUTO 24008G18KT 210V280 4000 1200N +TSRA BR FEW008 SCT015CB BKN030 OVC050 18\\/17 Q0998 RETS TEMPO 3000",
+    };
+    unsigned long firstWord[3];
+    for(int i=0; i<3; i++) firstWord[i] = measure(reports[i]);
+
+    // Speech starts after the first groups are converted, so a longer report must not delay the first word
+    check(firstWord[2] < firstWord[0] + 1000, "first word");
+
+    // Without a manifest no compound clips are loaded, so every token is its own clip
+    writeCompounds();
+    bool matched = true;
+    for(const char* report : reports){
+        int tokens, expected;
+        loadCompounds(slowVoicepack);
+        int before = countClips(report, tokens);
+        loadCompounds(voicepack);
+        int after = countClips(report, expected);
+        printf("%3d tokens: %3d clips without compound clips, %3d with\n", tokens, before, after);
+        matched = matched && before == tokens && after == expected && after < before;
+    }
+    check(matched, "compound clips");
+
+    loadFormat(slowVoicepack);
+    int underruns[4];
+    unsigned long times[4] = {0, 1000, 4000, 16000};
+    for(int i=0; i<4; i++) underruns[i] = playSlowly(times[i]);
+    // Reading ahead hides a card that takes up to about 1 ms per sector
+    check(underruns[0] == 0 && underruns[1] == 0, "slow SD card");
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -r %s", root);
+    system(command);
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
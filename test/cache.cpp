@@ -0,0 +1,143 @@
+/**
+ * ATIS token audio cache test.
+ * This file checks that 8-bit clips are cached and time-scaled as signed 16-bit samples.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "host.h"
+#include "cache.h"
+#include "timescale.h"
+
+#define CLIP_SAMPLES 8000
+
+int failed = 0;
+
+void check(bool passed, const char* name){
+    printf("%-24s %s\n", name, passed ? "ok" : "FAIL");
+    failed += !passed;
+}
+
+bool never(){
+    return false;
+}
+
+// The unsigned 8-bit sample at a position of the test clip
+uint8_t clipSample(int i){
+    return 128 + 100*sin(i * 0.05);
+}
+
+void writeClip(const char* path){
+    uint32_t size = CLIP_SAMPLES;
+    uint32_t header[11] = {
+        0x46464952, size+36, 0x45564157,                        // "RIFF", size, "WAVE"
+        0x20746D66, 16, 1 | (1 << 16), 8000, 8000, 1 | (8 << 16), // "fmt ", PCM, mono, 8 bits
+        0x61746164, size,                                       // "data", size
+    };
+    File clip = SD.open(path, FILE_WRITE);
+    clip.write((const uint8_t*)header, sizeof(header));
+    for(int i=0; i<CLIP_SAMPLES; i++) clip.write(clipSample(i));
+    clip.close();
+}
+
+// An output that keeps the samples written to it
+class AudioOutputCapture : public AudioOutput {
+    public:
+        virtual bool begin() override { size_samples = 0; return true; }
+        virtual bool ConsumeSample(int16_t sample[2]) override {
+            if(size_samples < CLIP_SAMPLES) samples[size_samples++] = sample[LEFTCHANNEL];
+            return true;
+        }
+        virtual bool stop() override { return true; }
+        int getBitsPerSample(){ return bps; }
+
+        int16_t samples[CLIP_SAMPLES];
+        int size_samples;
+};
+
+/**
+ * @brief Caches an 8-bit clip and checks that the cached file holds the same samples as signed 16-bit ones.
+ *
+ * @return true if every cached sample matches the clip
+ */
+bool cacheClip(){
+    TokenType token = TokenType(0);
+    char path[100];
+    clipPath(path, 100, tokenFilenames[token], VOICEPACK);
+    writeClip(path);
+
+    loadCache(VOICEPACK);
+    countTokens(&token, 1);
+    updateCache(VOICEPACK, never);
+    if(!isCached(token)) return false;
+
+    cachePath(path, 100, token, VOICEPACK);
+    File cached = LittleFS.open(path, "r");
+    uint8_t header[44];
+    cached.read(header, 44);
+    bool passed = header[34] == 16 && cached.size() == 44 + 2*CLIP_SAMPLES;
+    for(int i=0; i<CLIP_SAMPLES && passed; i++){
+        int16_t sample = 0;
+        cached.read((uint8_t*)&sample, 2);
+        passed = sample == (clipSample(i) - 128) << 8;
+    }
+    cached.close();
+    return passed;
+}
+
+/**
+ * @brief Time-scales 8-bit silence and checks that it comes out as 16-bit silence instead of a DC offset.
+ *
+ * @return true if the sink was told 16 bits and every sample is zero
+ */
+bool timeScaleSilence(){
+    AudioOutputCapture capture;
+    AudioOutputTimeScale timescale(&capture, 150);
+    timescale.SetRate(8000);
+    timescale.SetBitsPerSample(8);
+    timescale.SetChannels(1);
+    timescale.begin();
+    for(int i=0; i<CLIP_SAMPLES; i++){
+        int16_t sample[2] = {128, 0};
+        timescale.ConsumeSample(sample);
+    }
+    timescale.stop();
+
+    bool passed = capture.getBitsPerSample() == 16 && capture.size_samples > 0;
+    for(int i=0; i<capture.size_samples; i++) passed = passed && capture.samples[i] == 0;
+    return passed;
+}
+
+int main(){
+    char root[] = "/tmp/atis-cache-XXXXXX";
+    setFileRoot(mkdtemp(root));
+    SD.mkdir("/audio/" VOICEPACK);
+    LittleFS.mkdir("/cache/" VOICEPACK);
+    File format = SD.open("/audio/" VOICEPACK "/format.txt", FILE_WRITE);
+    format.write((const uint8_t*)"wav", 3);
+    format.close();
+    loadFormat(VOICEPACK);
+
+    check(cacheClip(), "cache 8-bit clip");
+    check(timeScaleSilence(), "time-scale 8-bit clip");
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -r %s", root);
+    system(command);
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/**
+ * ATIS cancellation test.
+ * This file measures how long a clip keeps playing after a button press, and how long it takes until the
+ * broadcast is heard again from the top, with a stand-in decoder that takes about as long per frame as MP3 decoding does on the ESP8266.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <thread>
+
+#include "host.h"
+#include "player.h"
+#include "poller.h"
+#include "timescale.h"
+
+#define PRESSES 25
+#define FRAME_SAMPLES 576
+#define FRAME_TIME 4000
+
+bool isCancelled();
+
+// A decoder that spends `FRAME_TIME` microseconds on each frame of silence
+class AudioGeneratorBusy : public AudioGenerator {
+    public:
+        /**
+         * @param[in] length The number of frames in the clip
+         */
+        AudioGeneratorBusy(int length) : length(length){ firstSample = 0; }
+
+        virtual bool begin(AudioFileSource* source, AudioOutput* output) override {
+            this->output = output;
+            output->SetRate(16000);
+            output->SetChannels(1);
+            output->begin();
+            frames = 0;
+            left = 0;
+            running = true;
+            return true;
+        }
+
+        virtual bool loop() override {
+            // Like the real decoders, a loop decodes at most one frame and returns once the output is full
+            while(running){
+                if(left == 0){
+                    if(frames++ >= length) return stop();
+                    unsigned long start = micros();
+                    while(micros() - start < FRAME_TIME);
+                    left = FRAME_SAMPLES;
+                }
+                int16_t sample[2] = {0, 0};
+                if(!output->ConsumeSample(sample)) return true;
+                if(firstSample == 0) firstSample = micros();
+                left--;
+            }
+            return false;
+        }
+
+        virtual bool stop() override {
+            if(running) output->stop();
+            running = false;
+            return false;
+        }
+
+        unsigned long firstSample;  // When the first sample was written to the output, or 0
+
+    private:
+        int length;
+        int frames;
+        int left;
+};
+
+/**
+ * @brief Presses the button at random times during a clip, and prints the percentiles of how long playback took to stop
+ * and how long it took until the first sample of the restarted broadcast.
+ * 
+ * @param[in] rate The speech rate in percent, where 100 plays straight to the speaker
+ * @return true if playback stopped within about one frame, and restarted once the first frame of the restart was decoded
+ */
+bool measure(int rate){
+    unsigned long stopped[PRESSES];
+    unsigned long restarted[PRESSES];
+    for(int i=0; i<PRESSES; i++){
+        AudioOutputI2SNoDAC out;
+        AudioOutputTimeScale timescale(&out, rate, isCancelled);
+        AudioOutput* sink = rate == 100 ? (AudioOutput*)&out : &timescale;
+        AudioGeneratorBusy decoder(100);
+        AudioFileSourcePrefetch clip;
+
+        clearCancel();
+        unsigned long pressed = 0;
+        std::thread button([&pressed]{
+            delay(100 + random(1000));
+            pressed = micros();
+            cancelPlayback(X_BUTTON);
+        });
+        playAudio(&decoder, &clip, NULL, sink);
+        stopped[i] = micros() - pressed;
+        button.join();
+
+        // Like in the sketch's loop, a due poll is put off while a press is pending, instead of downloading for up to FETCH_DEADLINE first
+        if(isPollDue() && getCancelReason() == X_NONE) delay(FETCH_DEADLINE);
+        clearCancel();
+        AudioGeneratorBusy restart(1);
+        playAudio(&restart, &clip, NULL, sink);
+        restarted[i] = restart.firstSample - pressed;
+    }
+
+    unsigned long p50 = percentile(stopped, PRESSES, 50);
+    unsigned long p99 = percentile(stopped, PRESSES, 99);
+    printf("rate %3d: stopped p50 %5.1f ms, p99 %5.1f ms", rate, p50/1000.0, p99/1000.0);
+    bool passed = p99 < 2*FRAME_TIME;
+    p50 = percentile(restarted, PRESSES, 50);
+    p99 = percentile(restarted, PRESSES, 99);
+    printf(", restarted p50 %5.1f ms, p99 %5.1f ms\n", p50/1000.0, p99/1000.0);
+    return passed && p99 < 3*FRAME_TIME;
+}
+
+int main(){
+    // Playback must stop within about one frame instead of playing out the clip,
+    // and the broadcast must start again once the first frame of the restart is decoded
+    bool passed = true;
+    for(int rate : {100, 150, 200}) passed = measure(rate) && passed;
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+/**
+ * ATIS fetch test.
+ * This file measures how retrying slow requests at another endpoint cuts the tail of the download time,
+ * against stand-in servers on which one request in twenty stalls.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+
+#include "host.h"
+#include "networking.h"
+
+#define FETCHES 100
+#define WARMUP SIZE_FETCH_HISTORY
+#define STALL 2000
+
+extern int size_fetch_times;
+
+const char reply[] = "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\n\r\n"
+    "{\"p1\":\"METAR EFHK 121250Z 24008KT CAVOK 18\\/09 Q1012 NOSIG=\"}";
+const char unavailable[] = "HTTP/1.0 503 Service Unavailable\r\n\r\n";
+std::atomic<uint32_t> requests[3];
+
+unsigned long latency(int server){
+    // The stalls are spread pseudo-randomly, but the same way on every run
+    uint32_t hash = (++requests[server] + 1000*server) * 2654435761u;
+    return (hash >> 16) % 20 == 0 ? STALL : 20;
+}
+
+unsigned long first(){ return latency(0); }
+unsigned long second(){ return latency(1); }
+
+// An endpoint that fails, but only after longer than the learned hedging delay
+unsigned long failing(){
+    requests[2]++;
+    return 100;
+}
+
+bool waitOut(const char* url){
+    char response[SIZE_RESPONSE];
+    Fetch fetch = {};
+    fetch.response = response;
+    fetch.size_response = SIZE_RESPONSE;
+    if(!startFetch(fetch, url, FETCH_DEADLINE)) return false;
+
+    FetchState state = F_PENDING;
+    while(state == F_PENDING){
+        state = stepFetch(fetch);
+        delay(1);
+    }
+    stopFetch(fetch);
+    return state == F_DONE;
+}
+
+bool fetch(const char* url){
+    char response[SIZE_RESPONSE];
+    getMetar(response, SIZE_RESPONSE, url);
+    return hasMetar(response);
+}
+
+/**
+ * @brief Fetches the METAR repeatedly and prints the percentiles of the time taken.
+ * 
+ * @param[in] name A pointer to a char array with the name of the strategy
+ * @param[in] strategy A function that fetches the METAR once and returns whether it succeeded
+ * @param[in] url A pointer to a char array with the URLs to fetch from
+ * @param[out] p99 The 99th percentile of the time taken, passed by reference
+ * @return The number of failed fetches
+ */
+int measure(const char* name, bool (*strategy)(const char*), const char* url, unsigned long& p99){
+    // The fetch history is cleared and learned again, so every strategy starts from the same state
+    size_fetch_times = 0;
+    requests[0] = 0;
+    requests[1] = 0;
+    for(int i=0; i<WARMUP; i++) strategy(url);
+
+    unsigned long times[FETCHES];
+    int failed = 0;
+    for(int i=0; i<FETCHES; i++){
+        unsigned long start = millis();
+        failed += !strategy(url);
+        times[i] = millis() - start;
+    }
+
+    unsigned long p50 = percentile(times, FETCHES, 50);
+    p99 = percentile(times, FETCHES, 99);
+    printf("%-8s p50 %4lu ms, p99 %4lu ms, %d failed\n", name, p50, p99, failed);
+    return failed;
+}
+
+/**
+ * @brief Fetches from an endpoint that fails slowly followed by a quick one, and counts how often the failing one is asked.
+ * The quick request must not count as slow just because the failed one took long.
+ * 
+ * @param[in] url A pointer to a char array with the URLs to fetch from
+ * @return true if the failing endpoint was asked once per fetch
+ */
+bool failOver(const char* url){
+    size_fetch_times = 0;
+    for(int i=0; i<WARMUP; i++) fetch(url + strcspn(url, " ") + 1);
+
+    requests[2] = 0;
+    int failed = 0;
+    for(int i=0; i<FETCHES/10; i++) failed += !fetch(url);
+    printf("failover %u requests to the failing endpoint for %d fetches, %d failed\n", requests[2].load(), FETCHES/10, failed);
+    return failed == 0 && requests[2] == FETCHES/10;
+}
+
+int main(){
+    char one[SIZE_URL];
+    char both[SIZE_URL];
+    uint16_t port0 = startServer(reply, sizeof(reply)-1, first);
+    uint16_t port1 = startServer(reply, sizeof(reply)-1, second);
+    snprintf(one, SIZE_URL, "http://127.0.0.1:%u/metar", port0);
+    snprintf(both, SIZE_URL, "http://127.0.0.1:%u/metar http://127.0.0.1:%u/metar", port0, port1);
+
+    unsigned long single, retried, hedged;
+    int failed = measure("single", waitOut, one, single);
+    setFreeHeap(FETCH_HEDGE_HEAP-1);
+    failed += measure("retry", fetch, both, retried);
+    setFreeHeap(FETCH_HEDGE_HEAP);
+    failed += measure("hedge", fetch, both, hedged);
+
+    char failover[SIZE_URL];
+    uint16_t port2 = startServer(unavailable, sizeof(unavailable)-1, failing);
+    snprintf(failover, SIZE_URL, "http://127.0.0.1:%u/metar http://127.0.0.1:%u/metar", port2, port1);
+    setFreeHeap(FETCH_HEDGE_HEAP-1);
+    failed += !failOver(failover);
+
+    // Without retries, the slowest fetches wait out a stall
+    bool passed = failed == 0 && single >= STALL && retried < STALL && hedged < STALL;
+    printf("%s\n", passed ? "PASS" : "FAIL");
+    return passed ? 0 : 1;
+}
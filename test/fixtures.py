@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+"""
+Generates the compressed responses that test/inflate.cpp decompresses.
+The generated files are committed, so the tests only need a C++ compiler.
+
+Usage:
+    fixtures.py
+
+"""
+
+import gzip
+import json
+import os
+import random
+import zlib
+
+DIRECTORY = os.path.join(os.path.dirname(os.path.abspath(__file__)), "fixtures")
+WINDOW = 1024  # INFLATE_WINDOW in atis/config.h
+
+
+def response(names, metars):
+    """A response in the shape of ilmailusaa.fi's, with a report from each station in the order given.
+    Only the stations in `metars` have a METAR, the rest are automatic weather stations."""
+    stations = []
+    for i, name in enumerate(names):
+        station = {
+            "_locationName": name,
+            "lat": round(60.3 + i * 0.21, 4),
+            "lon": round(24.9 - i * 0.37, 4),
+            "t": 12.4 - i,
+            "wd": 240 + 10 * i,
+            "ws": 8 + i,
+            "vis": 9999,
+            "p0": f"{name} 121250Z",
+            "p1": f"METAR {name} 121250Z 24008KT 210V270 CAVOK 18/09 Q1012 NOSIG=",
+            "p2": f"TAF {name} 121100Z 1212/1312 24010KT CAVOK BECMG 1218/1220 20005KT=",
+        }
+        if name not in metars:
+            del station["p1"], station["p2"]
+        stations.append(station)
+    return json.dumps(stations, separators=(",", ":")).replace("/", "\\/").encode()
+
+
+def write(name, data):
+    with open(os.path.join(DIRECTORY, name), "wb") as file:
+        file.write(data)
+
+
+def deflate(data, level=9, wbits=-15, strategy=zlib.Z_DEFAULT_STRATEGY):
+    compressor = zlib.compressobj(level, zlib.DEFLATED, wbits, 9, strategy)
+    return compressor.compress(data) + compressor.flush()
+
+
+def main():
+    os.makedirs(DIRECTORY, exist_ok=True)
+    names = ["ILZM", "EFHK", "EFTU", "EFTP", "EFLP", "EFPO"]
+    data = response(names, names)
+    write("response.json", data)
+
+    # The same response in every container and block type that the decompressor reads
+    write("response.gz", gzip.compress(data, mtime=0))
+    write("response.zz", deflate(data, wbits=15))
+    write("response.deflate", deflate(data))
+    write("stored.gz", deflate(data, level=0, wbits=31))
+    write("fixed.zz", deflate(data, wbits=15, strategy=zlib.Z_FIXED))
+
+    # A gzip header with a file name, comment and extra field, which nginx and others may send
+    header = bytes([0x1f, 0x8b, 8, 0x1c, 0, 0, 0, 0, 2, 3])
+    extra = b"AB\x02\x00hi"
+    header += len(extra).to_bytes(2, "little") + extra + b"response.json\0" + b"from the tests\0"
+    write("named.gz", header + deflate(data) + zlib.crc32(data).to_bytes(4, "little") + len(data).to_bytes(4, "little"))
+
+    # The download stops at the first METAR, which here comes after an automatic weather station
+    late = response(names[1:2] + names[:1], names[:1])
+    write("late.json", late)
+    write("late.gz", gzip.compress(late, mtime=0))
+
+    # Refers back further than the decompressor keeps, so it must be rejected rather than decompressed wrongly
+    random.seed(1)
+    noise = bytes(random.randrange(256) for i in range(2 * WINDOW))
+    write("window.gz", gzip.compress(noise + noise[:200], mtime=0))
+
+
+if __name__ == "__main__":
+    main()
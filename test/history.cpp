@@ -0,0 +1,113 @@
+/**
+ * ATIS history test.
+ * This file checks that the history log and its index recover from writes cut short by a power loss.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "host.h"
+#include "history.h"
+
+int failed = 0;
+
+void check(bool passed, const char* name){
+    printf("%-24s %s\n", name, passed ? "ok" : "FAIL");
+    failed += !passed;
+}
+
+MetarRecord makeRecord(uint32_t i){
+    MetarRecord record = {};
+    record.time = 1000 + 10*i;
+    record.qnh = i;
+    return record;
+}
+
+uint32_t fileSize(const char* path){
+    File file = SD.open(path, FILE_READ);
+    uint32_t size = file.size();
+    file.close();
+    return size;
+}
+
+// Simulates a write cut short by a power loss
+void appendBytes(const char* path, int count){
+    File file = SD.open(path, FILE_WRITE);
+    for(int i=0; i<count; i++) file.write(0xAA);
+    file.close();
+}
+
+void cutFile(const char* path, uint32_t size){
+    File file = SD.open(path, FILE_WRITE);
+    file.truncate(size);
+    file.close();
+}
+
+/**
+ * @brief Checks that the log holds records 0 to `count`-1 and that every index entry and lookup agrees with them.
+ * 
+ * @param[in] count The number of records that should be in the log
+ * @return true if the log and index are consistent
+ */
+bool consistent(uint32_t count){
+    if(fileSize(PATH_HISTORY) != count * sizeof(MetarRecord)) return false;
+    uint32_t strides = (count + HISTORY_STRIDE - 1) / HISTORY_STRIDE;
+    if(fileSize(PATH_HISTORY_INDEX) != strides * sizeof(uint32_t)) return false;
+
+    File index = SD.open(PATH_HISTORY_INDEX, FILE_READ);
+    for(uint32_t i=0; i<strides; i++){
+        uint32_t time = 0;
+        index.read((uint8_t*)&time, sizeof(uint32_t));
+        if(time != makeRecord(i * HISTORY_STRIDE).time) return false;
+    }
+    index.close();
+
+    for(uint32_t i=0; i<count; i++){
+        MetarRecord record;
+        if(!findRecord(record, makeRecord(i).time + 5) || record.qnh != i) return false;
+    }
+    MetarRecord last;
+    return lastRecords(&last, 1) == 1 && last.qnh == count-1;
+}
+
+int main(){
+    char root[] = "/tmp/atis-history-XXXXXX";
+    setFileRoot(mkdtemp(root));
+
+    uint32_t count = 0;
+    while(count < 3*HISTORY_STRIDE) appendRecord(makeRecord(count++));
+    check(consistent(count), "append");
+
+    appendBytes(PATH_HISTORY, sizeof(MetarRecord)/2);
+    appendRecord(makeRecord(count++));
+    check(consistent(count), "torn record");
+
+    // The next record starts a new stride, so its index entry is written
+    while(count % HISTORY_STRIDE != 0) appendRecord(makeRecord(count++));
+    appendBytes(PATH_HISTORY_INDEX, 2);
+    appendRecord(makeRecord(count++));
+    check(consistent(count), "torn index entry");
+
+    cutFile(PATH_HISTORY_INDEX, sizeof(uint32_t));
+    appendRecord(makeRecord(count++));
+    check(consistent(count), "lost index entries");
+
+    char command[64];
+    snprintf(command, sizeof(command), "rm -r %s", root);
+    system(command);
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/**
+ * ATIS decompression test.
+ * This file decompresses the responses in fixtures/, which are generated by fixtures.py,
+ * and compares how many bytes a compressed and an uncompressed download read before the METAR has arrived,
+ * both when the METAR is at the start of the response and when it is at the end.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "host.h"
+#include "inflate.h"
+#include "networking.h"
+
+#define RATE 2000
+
+/**
+ * @brief Reads a whole fixture file.
+ * 
+ * @param[in] name A pointer to a char array with the name of the file in fixtures/
+ * @return The contents of the file
+ */
+std::string readFixture(const char* name){
+    std::ifstream file(std::string("fixtures/") + name, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+void appendOutput(uint8_t byte, void* context){
+    ((std::string*)context)->push_back(byte);
+}
+
+/**
+ * @brief Decompresses a fixture one byte at a time, like the bytes arrive from the network.
+ * 
+ * @param[in] name A pointer to a char array with the name of the file in fixtures/
+ * @param[in] encoding The container format of the file
+ * @param[out] output The decompressed data, passed by reference
+ * @param[in] size_input The number of bytes of the file to decompress, or -1 for all of them
+ * @return true if the decompressor accepted every byte and the stream was complete
+ */
+bool inflateFixture(const char* name, ContentEncoding encoding, std::string& output, int size_input = -1){
+    std::string input = readFixture(name);
+    if(size_input >= 0) input.resize(size_input);
+
+    Inflater inflater(appendOutput, &output);
+    inflater.begin(encoding);
+    for(char c : input){
+        if(!inflater.write(c)) return false;
+    }
+    return inflater.finish();
+}
+
+int testFixtures(){
+    const std::string expected = readFixture("response.json");
+    const struct {
+        const char* name;
+        ContentEncoding encoding;
+    } fixtures[] = {
+        {"response.gz", E_GZIP},
+        {"response.zz", E_DEFLATE},
+        {"response.deflate", E_DEFLATE},
+        {"stored.gz", E_GZIP},
+        {"fixed.zz", E_DEFLATE},
+        {"named.gz", E_GZIP},
+    };
+
+    int failed = 0;
+    for(const auto& fixture : fixtures){
+        std::string output;
+        bool passed = inflateFixture(fixture.name, fixture.encoding, output) && output == expected;
+        printf("%-18s %s\n", fixture.name, passed ? "ok" : "FAIL");
+        failed += !passed;
+    }
+
+    // A stream that ends early or refers back past the window must fail instead of producing wrong data
+    std::string output;
+    bool truncated = !inflateFixture("response.gz", E_GZIP, output, readFixture("response.gz").size()/2);
+    truncated = truncated && expected.compare(0, output.size(), output) == 0;
+    printf("%-18s %s\n", "truncated", truncated ? "ok" : "FAIL");
+    failed += !truncated;
+    output.clear();
+    bool window = !inflateFixture("window.gz", E_GZIP, output);
+    printf("%-18s %s\n", "window.gz", window ? "ok" : "FAIL");
+    failed += !window;
+    return failed;
+}
+
+unsigned long noLatency(){
+    return 0;
+}
+
+/**
+ * @brief Downloads the METAR from a stand-in server over a slow link and prints how many bytes were read and how long it took.
+ * 
+ * @param[in] name A pointer to a char array with the name of the encoding
+ * @param[in] encoding A pointer to a char array with the Content-Encoding header, or an empty string for none
+ * @param[in] body The response body
+ * @param[out] received The number of bytes read, passed by reference
+ * @return true if the METAR was downloaded
+ */
+bool download(const char* name, const char* encoding, const std::string& body, uint32_t& received){
+    std::string response = std::string("HTTP/1.0 200 OK\r\nContent-Type: application/json\r\n") + encoding + "\r\n" + body;
+    uint16_t port = startServer(response.data(), response.size(), noLatency, RATE);
+    char url[SIZE_URL];
+    snprintf(url, SIZE_URL, "http://127.0.0.1:%u/metar", port);
+
+    char raw[SIZE_RESPONSE];
+    uint32_t before = getBytesReceived();
+    unsigned long start = millis();
+    getMetar(raw, SIZE_RESPONSE, url);
+    unsigned long time = millis() - start;
+    received = getBytesReceived() - before;
+
+    char metar[SIZE_METAR];
+    decodeMetar(metar, SIZE_METAR, raw, SIZE_RESPONSE);
+    printf("%-8s %4u bytes read, METAR after %4lu ms: %s\n", name, received, time, metar);
+    return hasMetar(raw);
+}
+
+int main(){
+    int failed = testFixtures();
+
+    // When the METAR comes first, the download stops before compression has saved anything
+    uint32_t identity, gzip;
+    failed += !download("identity", "", readFixture("response.json"), identity);
+    failed += !download("gzip", "Content-Encoding: gzip\r\n", readFixture("response.gz"), gzip);
+
+    // Further into the response, it reads fewer bytes than the uncompressed download
+    failed += !download("identity", "", readFixture("late.json"), identity);
+    failed += !download("gzip", "Content-Encoding: gzip\r\n", readFixture("late.gz"), gzip);
+    failed += gzip >= identity;
+
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
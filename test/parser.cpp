@@ -0,0 +1,186 @@
+/**
+ * ATIS parser test.
+ * This file checks the shortcuts in splitting and classifying METAR information against straightforward versions of the same code.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "host.h"
+#include "networking.h"
+#include "parser.h"
+
+#define MUTATIONS 20000
+#define SPLITS 200000
+
+int failed = 0;
+
+void check(bool passed, const char* name){
+    printf("%-10s %s\n", name, passed ? "ok" : "FAIL");
+    failed += !passed;
+}
+
+// Classifies a group by trying every regex in order, without checking its shape first
+InformationType classifyAll(const char* group, std::cmatch& match){
+    for(const GroupPattern& it : regexToToken){
+        if(std::regex_match(group, match, std::regex(it.regex))) return it.type;
+    }
+    return I_ERROR;
+}
+
+bool sameMatch(const std::cmatch& a, const std::cmatch& b){
+    if(a.size() != b.size()) return false;
+    for(size_t i=0; i<a.size(); i++){
+        if(a[i].matched != b[i].matched || a[i].str() != b[i].str()) return false;
+    }
+    return true;
+}
+
+// Classifies real groups and random mutations of them, which the shape check must never change the result of
+void testShapes(){
+    const std::vector<std::string> seeds = {
+        "ILZM", "EFHK", "ILZD", "011250Z", "NIL", "AUTO", "24010KT", "VRB03G15KT", "00000KT", "\\/\\/\\/\\/\\/KT", "210V280",
+        "CAVOK", "9999", "\\/\\/\\/\\/", "0800", "R27\\/1200", "R04\\/M0050U", "R15\\/P1500N", "FEW030", "BKN045CB",
+        "SCT012TCU", "\\/\\/\\/\\/\\/\\/", "\\/\\/\\/\\/\\/\\/CB", "NSC", "NCD", "VV002", "M05\\/M07", "05\\/M07",
+        "Q1013", "Q\\/\\/\\/\\/", "WS", "ALL", "RWY", "R27", "-SHRA", "+TSRAGR", "RA", "\\/\\/", "BR", "-FZDZSN",
+        "RMK", "BECMG", "TEMPO", "NOSIG", "9999NDV", "M05/M07", "CAVOK=",
+    };
+    const char alphabet[] = "0123456789ABCDEFGKLMNOPQRSTUVWXYZ\\/+-=";
+    std::mt19937 random(1);
+
+    int checked = 0;
+    int mismatches = 0;
+    auto compare = [&](const std::string& group){
+        std::cmatch fast, slow;
+        InformationType type = classifyGroup(group.c_str(), fast);
+        bool same = type == classifyAll(group.c_str(), slow) && (type == I_ERROR || sameMatch(fast, slow));
+        if(!same && mismatches < 10) printf("  %s\n", group.c_str());
+        mismatches += !same;
+        checked++;
+    };
+
+    for(const std::string& seed : seeds) compare(seed);
+    for(int i=0; i<MUTATIONS; i++){
+        // Insert, delete or replace up to three characters
+        std::string group = seeds[random() % seeds.size()];
+        int edits = 1 + random() % 3;
+        for(int j=0; j<edits; j++){
+            size_t pos = random() % (group.size()+1);
+            char c = alphabet[random() % (sizeof(alphabet)-1)];
+            int edit = random() % 3;
+            if(edit == 0) group.insert(group.begin()+pos, c);
+            else if(pos < group.size() && edit == 1) group.erase(pos, 1);
+            else if(pos < group.size()) group[pos] = c;
+        }
+        if(!group.empty()) compare(group);
+    }
+
+    printf("%d groups, %d mismatches\n", checked, mismatches);
+    check(mismatches == 0, "shapes");
+}
+
+// Splits on every space one character at a time
+int splitAll(char** parsed, char* metar, int size_metar){
+    parsed[0] = metar;
+    int j = 1;
+    for(int i=0; i<size_metar; i++){
+        if(metar[i] != ' ') continue;
+        metar[i] = '\0';
+        parsed[j++] = metar + i + 1;
+    }
+    return j;
+}
+
+// Splits random strings of spaces, METAR characters and bytes with the high bit set, which the word-at-a-time search must not mistake for spaces
+void testSplit(){
+    const char alphabet[] = "AB1/\\\x80\xa0!";
+    std::mt19937 random(2);
+
+    int mismatches = 0;
+    for(int i=0; i<SPLITS; i++){
+        char fast[64];
+        char slow[64];
+        int size = random() % 60;
+        for(int j=0; j<size; j++) fast[j] = random() % 4 == 0 ? ' ' : alphabet[random() % (sizeof(alphabet)-1)];
+        fast[size] = '\0';
+        memcpy(slow, fast, size+1);
+
+        char* parsedFast[64];
+        char* parsedSlow[64];
+        int count = parseMetar(parsedFast, 64, fast, size);
+        bool same = count == splitAll(parsedSlow, slow, size) && memcmp(fast, slow, size) == 0;
+        for(int j=0; same && j<count; j++) same = parsedFast[j]-fast == parsedSlow[j]-slow;
+        mismatches += !same;
+    }
+
+    printf("%d strings, %d mismatches\n", SPLITS, mismatches);
+    check(mismatches == 0, "split");
+}
+
+// Generates a series of reports with and without copying unchanged groups from the previous phrase, which must give the same speech
+void testReuse(){
+    const char* reports[] = {
+        "ILZM 011220Z AUTO 24010KT 9999 FEW030 M05\\/M07 Q1013",
+        "ILZM 011250Z AUTO 24010KT 9999 FEW030 M05\\/M07 Q1012",
+        "ILZM 011320Z AUTO 25012G22KT 210V280 8000 -SHRA FEW030CB BKN045 M04\\/M07 Q1012",
+        "ILZM 011350Z AUTO 25012G22KT 210V280 8000 -SHRA FEW030CB BKN045 M04\\/M07 Q1012",
+        "ILZM 011420Z AUTO 25012KT 9999 NSC M04\\/M06 Q1011",
+        // The wind and the temperature below have the same hash
+        "ILZM 011450Z AUTO 12698G74KT 9999 NSC M04\\/M06 Q1011",
+        "ILZM 011520Z AUTO 25012KT 9999 NSC M06\\/M84 Q1011",
+    };
+
+    TokenType phrase[2][SIZE_PHRASE];
+    Segment segments[2][SIZE_PARSED];
+    int size_segments = 0;
+    int current = 0;
+    bool same = true;
+    char metar[2][SIZE_METAR];
+    for(const char* report : reports){
+        int next = 1-current;
+        char* parsed[SIZE_PARSED];
+        strncpy(metar[next], report, SIZE_METAR);
+        int size_parsed = parseMetar(parsed, SIZE_PARSED, metar[next], strlen(metar[next]));
+
+        TokenType full[SIZE_PHRASE];
+        Segment fullSegments[SIZE_PARSED];
+        int size_full = generatePhrase(full, SIZE_PHRASE, fullSegments, parsed, size_parsed, NULL, NULL, NULL, 0);
+        int size_phrase = generatePhrase(phrase[next], SIZE_PHRASE, segments[next], parsed, size_parsed, phrase[current], metar[current], segments[current], size_segments);
+
+        // The information letter is chosen when the time is converted, so it may differ between the two
+        same = same && size_phrase == size_full;
+        for(int i=0; same && i<size_parsed; i++){
+            const Segment& a = segments[next][i];
+            const Segment& b = fullSegments[i];
+            same = a.type == b.type && a.start == b.start && a.length == b.length;
+            if(same && a.type != I_TIME) same = memcmp(phrase[next]+a.start, full+b.start, a.length*sizeof(TokenType)) == 0;
+        }
+        size_segments = size_parsed;
+        current = next;
+    }
+
+    check(same, "reuse");
+}
+
+int main(){
+    testShapes();
+    testSplit();
+    testReuse();
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+/**
+ * ATIS host test stub of the ESP8266 Arduino core.
+ * Only what the ATIS sources use is declared, and it behaves like the core where the tests depend on it.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_ARDUINO
+#define ATIS_STUB_ARDUINO
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <time.h>
+
+#define PROGMEM
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define PI 3.1415926535897932384626433832795
+
+#define D1 5
+#define D2 4
+#define D4 2
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define FALLING 2
+
+#define constrain(x, low, high) ((x)<(low) ? (low) : ((x)>(high) ? (high) : (x)))
+using std::min;
+using std::max;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long low, long high);
+long random(long high);
+
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+inline int digitalPinToInterrupt(int pin){ return pin; }
+void attachInterrupt(int interrupt, void (*handler)(), int mode);
+
+inline void configTime(int timezone, int daylight, const char* server){}
+
+// The serial port accepts everything and throws it away
+class HardwareSerial {
+    public:
+        void begin(unsigned long baud){}
+        int availableForWrite(){ return 128; }
+        size_t write(const uint8_t* data, size_t size){ return size; }
+        size_t write(const char* data, size_t size){ return size; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+    public:
+        uint8_t getCpuFreqMHz(){ return 80; }
+        uint32_t getCycleCount();
+        uint32_t getFreeHeap();
+        uint32_t getMaxFreeBlockSize();
+};
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,42 @@
+/**
+ * ATIS host test stub of the ESP8266Audio SD card file source.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOFILESOURCESD
+#define ATIS_STUB_AUDIOFILESOURCESD
+
+#include <SD.h>
+
+#include "AudioFileSource.h"
+
+class AudioFileSourceSD : public AudioFileSource {
+    public:
+        AudioFileSourceSD(){}
+        AudioFileSourceSD(const char* filename){ open(filename); }
+        virtual bool open(const char* filename) override { f = SD.open(filename, FILE_READ); return f; }
+        virtual uint32_t read(void* data, uint32_t len) override { return f ? f.read((uint8_t*)data, len) : 0; }
+        virtual bool seek(int32_t pos, int dir) override { return f && f.seek(pos, (SeekMode)dir); }
+        virtual bool close() override { f.close(); return true; }
+        virtual bool isOpen() override { return f; }
+        virtual uint32_t getSize() override { return f ? f.size() : 0; }
+        virtual uint32_t getPos() override { return f ? f.position() : 0; }
+
+    private:
+        File f;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/**
+ * ATIS host test stub of the ESP8266Audio decoder base class.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOGENERATOR
+#define ATIS_STUB_AUDIOGENERATOR
+
+#include "AudioFileSource.h"
+#include "AudioOutput.h"
+
+class AudioGenerator {
+    public:
+        AudioGenerator(){ running = false; file = NULL; output = NULL; lastSample[0] = 0; lastSample[1] = 0; }
+        virtual ~AudioGenerator(){}
+        virtual bool begin(AudioFileSource* source, AudioOutput* output){ return false; }
+        virtual bool loop(){ return false; }
+        virtual bool stop(){ return false; }
+        virtual bool isRunning(){ return running; }
+
+    protected:
+        bool running;
+        AudioFileSource* file;
+        AudioOutput* output;
+        int16_t lastSample[2];
+};
+
+#endif
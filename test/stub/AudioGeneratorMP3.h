@@ -0,0 +1,26 @@
+/**
+ * ATIS host test stub of an ESP8266Audio decoder. It cannot decode, so clips played with it end at once.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOGENERATORMP3
+#define ATIS_STUB_AUDIOGENERATORMP3
+
+#include "AudioGenerator.h"
+
+class AudioGeneratorMP3 : public AudioGenerator {};
+
+#endif
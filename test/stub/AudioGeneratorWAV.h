@@ -0,0 +1,80 @@
+/**
+ * ATIS host test stub of the ESP8266Audio WAV decoder. It reads PCM files with the plain 44-byte header,
+ * and like the real decoder it passes 8-bit samples on unconverted.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOGENERATORWAV
+#define ATIS_STUB_AUDIOGENERATORWAV
+
+#include "AudioGenerator.h"
+
+class AudioGeneratorWAV : public AudioGenerator {
+    public:
+        virtual bool begin(AudioFileSource* source, AudioOutput* output) override {
+            file = source;
+            this->output = output;
+            uint8_t header[44];
+            if(file->read(header, 44) != 44 || memcmp(header, "RIFF", 4) != 0 || memcmp(header+36, "data", 4) != 0) return false;
+            channels = header[22];
+            bits = header[34];
+            remaining = header[40] | (header[41] << 8) | (header[42] << 16) | ((uint32_t)header[43] << 24);
+
+            output->SetRate(header[24] | (header[25] << 8) | (header[26] << 16));
+            output->SetBitsPerSample(bits);
+            output->SetChannels(channels);
+            if(!output->begin()) return false;
+            pending = false;
+            running = true;
+            return true;
+        }
+
+        virtual bool loop() override {
+            while(running){
+                if(!pending && !readSample()) return stop();
+                pending = true;
+                if(!output->ConsumeSample(lastSample)) return true;
+                pending = false;
+            }
+            return false;
+        }
+
+        virtual bool stop() override {
+            if(running) output->stop();
+            running = false;
+            return false;
+        }
+
+    private:
+        bool readSample(){
+            uint32_t size = channels * bits / 8;
+            uint8_t data[4] = {};
+            if(remaining < size || file->read(data, size) != size) return false;
+            remaining -= size;
+            for(int i=0; i<channels; i++){
+                lastSample[i] = bits == 8 ? data[i] : (int16_t)(data[2*i] | (data[2*i+1] << 8));
+            }
+            if(channels == 1) lastSample[AudioOutput::RIGHTCHANNEL] = 0;
+            return true;
+        }
+
+        int channels;
+        int bits;
+        uint32_t remaining;
+        bool pending;           // Whether `lastSample` still has to be written to the output
+};
+
+#endif
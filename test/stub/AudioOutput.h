@@ -0,0 +1,53 @@
+/**
+ * ATIS host test stub of the ESP8266Audio output base class.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOOUTPUT
+#define ATIS_STUB_AUDIOOUTPUT
+
+#include <Arduino.h>
+
+class AudioOutput {
+    public:
+        AudioOutput(){ hertz = 0; bps = 16; channels = 2; }
+        virtual ~AudioOutput(){}
+        virtual bool SetRate(int hz){ hertz = hz; return true; }
+        virtual bool SetBitsPerSample(int bits){ bps = bits; return true; }
+        virtual bool SetChannels(int channels){ this->channels = channels; return true; }
+        virtual bool SetGain(float gain){ return true; }
+        virtual bool begin(){ return false; }
+        virtual bool ConsumeSample(int16_t sample[2]){ return false; }
+        virtual bool stop(){ return false; }
+        virtual bool loop(){ return true; }
+
+        enum {LEFTCHANNEL=0, RIGHTCHANNEL=1};
+
+    protected:
+        void MakeSampleStereo16(int16_t sample[2]){
+            if(channels == 1) sample[RIGHTCHANNEL] = sample[LEFTCHANNEL];
+            if(bps == 8){
+                sample[LEFTCHANNEL] = (((int16_t)(sample[LEFTCHANNEL]&0xff)) - 128) << 8;
+                sample[RIGHTCHANNEL] = (((int16_t)(sample[RIGHTCHANNEL]&0xff)) - 128) << 8;
+            }
+        }
+
+        uint16_t hertz;
+        uint8_t bps;
+        uint8_t channels;
+};
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * ATIS host test stub of the ESP8266Audio speaker output.
+ * Like the I2S DMA buffers, it accepts samples only as fast as they are played at the sample rate.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_AUDIOOUTPUTI2SNODAC
+#define ATIS_STUB_AUDIOOUTPUTI2SNODAC
+
+#include "AudioOutput.h"
+
+class AudioOutputI2SNoDAC : public AudioOutput {
+    public:
+        AudioOutputI2SNoDAC(int port=0){}
+        virtual bool begin() override;
+        virtual bool ConsumeSample(int16_t sample[2]) override;
+        virtual bool stop() override;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * ATIS host test stub of the ESP8266 WiFi library.
+ * WiFiClient is a blocking TCP connection on the host, so that requests can be tested against local stand-in servers.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_WIFI
+#define ATIS_STUB_WIFI
+
+#include <Arduino.h>
+
+#define WIFI_STA 1
+#define WL_CONNECTED 3
+
+class WiFiClient {
+    public:
+        WiFiClient();
+        virtual ~WiFiClient();
+
+        virtual int connect(const char* host, uint16_t port);
+        uint8_t connected();
+        int available();
+        int read();
+        size_t write(const uint8_t* data, size_t size);
+        size_t print(const char* text);
+        void setTimeout(unsigned long timeout);
+        void stop();
+
+    private:
+        int socket;
+        unsigned long timeout;
+};
+
+class WiFiClass {
+    public:
+        void mode(int mode){}
+        void begin(const char* ssid, const char* password){}
+        int status(){ return WL_CONNECTED; }
+};
+extern WiFiClass WiFi;
+
+#endif
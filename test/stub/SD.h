@@ -0,0 +1,74 @@
+/**
+ * ATIS host test stub of the ESP8266 SD library.
+ * Paths are mapped into a directory on the host, see host.h, and FILE_WRITE appends like it does on the ESP8266.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_SD
+#define ATIS_STUB_SD
+
+#include <memory>
+
+#include <Arduino.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "a+"
+
+enum SeekMode {
+    SeekSet,
+    SeekCur,
+    SeekEnd,
+};
+
+class File {
+    public:
+        File(){}
+        File(FILE* file, const char* mode, unsigned long (*latency)() = NULL);
+
+        operator bool() const { return file != nullptr; }
+        int read();
+        int read(uint8_t* data, size_t size);
+        size_t write(const uint8_t* data, size_t size);
+        size_t write(uint8_t data);
+        bool seek(uint32_t pos, SeekMode mode = SeekSet);
+        uint32_t position();
+        uint32_t size();
+        int available();
+        bool truncate(uint32_t size);
+        void flush();
+        void close();
+
+    private:
+        void waitForSectors(size_t size);
+
+        std::shared_ptr<FILE> file;
+        unsigned long (*latency)() = NULL;  // How long reading a sector takes, or NULL if reading takes no time
+        long cachedSector = -1;             // The sector read last, which is kept in RAM like in the SD library
+};
+
+class FSClass {
+    public:
+        bool begin(){ return true; }
+        bool begin(int pin){ return true; }
+        bool exists(const char* path);
+        File open(const char* path, const char* mode = FILE_READ);
+        bool mkdir(const char* path);
+        bool remove(const char* path);
+};
+typedef FSClass SDClass;
+extern SDClass SD;
+
+#endif
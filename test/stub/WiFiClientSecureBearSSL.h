@@ -0,0 +1,32 @@
+/**
+ * ATIS host test stub of the BearSSL client.
+ * It does not speak TLS, so tests use http:// stand-in servers.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_BEARSSL
+#define ATIS_STUB_BEARSSL
+
+#include <ESP8266WiFi.h>
+
+namespace BearSSL {
+    class WiFiClientSecure : public WiFiClient {
+        public:
+            void setInsecure(){}
+    };
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * ATIS host test helper header file.
+ * This file contains the controls that tests have over the stubbed ESP8266 core, and helpers shared by the tests.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ATIS_STUB_HOST
+#define ATIS_STUB_HOST
+
+#include <Arduino.h>
+
+/**
+ * @brief Sets the directory on the host that the SD card and flash paths are mapped into.
+ * 
+ * @param[in] root A pointer to a char array with the path of an existing directory
+ */
+void setFileRoot(const char* root);
+
+/**
+ * @brief Sets the free memory that `ESP.getFreeHeap()` and `ESP.getMaxFreeBlockSize()` report.
+ * 
+ * @param[in] bytes The free memory in bytes
+ */
+void setFreeHeap(uint32_t bytes);
+
+/**
+ * @brief Gets the number of bytes that all WiFiClients have read, to measure the bytes on the wire.
+ * 
+ * @return The number of bytes read from the network since the program started
+ */
+uint32_t getBytesReceived();
+
+/**
+ * @brief Starts a stand-in HTTP server on the loopback interface in a background thread.
+ * Every request is answered with the same response after a delay chosen by `latency`.
+ * 
+ * @param[in] response A pointer to the whole HTTP response, including the headers
+ * @param[in] size_response The size of `response`
+ * @param[in] latency A function that returns the delay in milliseconds before each response is sent
+ * @param[in] rate The speed in bytes per second at which the response is sent, or 0 to send it at once
+ * @return The port that the server listens on
+ */
+uint16_t startServer(const char* response, int size_response, unsigned long (*latency)(), int rate = 0);
+
+/**
+ * @brief Makes the stand-in SD card slow. Every read waits for each 512-byte sector that it needs,
+ * except for the sector read last, which the SD library keeps in RAM.
+ * 
+ * @param[in] latency A function that returns how long reading a sector takes in microseconds, or NULL to read at once
+ */
+void setSdLatency(unsigned long (*latency)());
+
+/**
+ * @brief Gets when the stand-in speaker was given its first sample since the previous call, and starts watching again.
+ * 
+ * @return The `micros()` value when the first sample was played, or 0 if none was
+ */
+unsigned long getFirstSample();
+
+/**
+ * @brief Gets a percentile of a set of durations.
+ * 
+ * @param[out] times A pointer to an array of durations. It will be sorted
+ * @param[in] size_times The size of `times`
+ * @param[in] percentile The percentile to get, between 0 and 100
+ * @return The duration at the percentile
+ */
+unsigned long percentile(unsigned long* times, int size_times, int percentile);
+
+#endif
@@ -0,0 +1,372 @@
+/**
+ * ATIS host test stub program file.
+ * This file implements the stubbed ESP8266 core on top of the C++ standard library and POSIX.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <Arduino.h>
+#include <SD.h>
+#include <LittleFS.h>
+#include <ESP8266WiFi.h>
+#include <AudioOutputI2SNoDAC.h>
+#include <i2s.h>
+
+#include "host.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+SDClass SD;
+FSClass LittleFS;
+WiFiClass WiFi;
+
+std::string fileRoot = ".";
+std::atomic<uint32_t> freeHeap(40000);
+std::atomic<uint32_t> bytesReceived(0);
+std::atomic<unsigned long> firstSample(0);
+unsigned long (*sdLatency)() = NULL;
+const auto started = std::chrono::steady_clock::now();
+
+// The number of samples that the I2S DMA buffers hold
+#define SIZE_DMA 128
+// The size of an SD card sector in bytes
+#define SIZE_SD_SECTOR 512
+
+void setFileRoot(const char* root){
+    fileRoot = root;
+}
+
+void setFreeHeap(uint32_t bytes){
+    freeHeap = bytes;
+}
+
+void setSdLatency(unsigned long (*latency)()){
+    sdLatency = latency;
+}
+
+uint32_t getBytesReceived(){
+    return bytesReceived;
+}
+
+unsigned long getFirstSample(){
+    return firstSample.exchange(0);
+}
+
+unsigned long percentile(unsigned long* times, int size_times, int percentile){
+    std::sort(times, times+size_times);
+    return times[(size_times-1) * percentile / 100];
+}
+
+// Time
+
+unsigned long millis(){
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+unsigned long micros(){
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count();
+}
+
+void delay(unsigned long ms){
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield(){
+    std::this_thread::yield();
+}
+
+long random(long low, long high){
+    return low + rand() % (high-low);
+}
+
+long random(long high){
+    return random(0, high);
+}
+
+uint32_t EspClass::getCycleCount(){
+    return micros() * getCpuFreqMHz();
+}
+
+uint32_t EspClass::getFreeHeap(){
+    return freeHeap;
+}
+
+uint32_t EspClass::getMaxFreeBlockSize(){
+    return freeHeap;
+}
+
+// Pins do nothing
+
+void pinMode(int pin, int mode){}
+void digitalWrite(int pin, int value){}
+int digitalRead(int pin){ return HIGH; }
+void attachInterrupt(int interrupt, void (*handler)(), int mode){}
+
+// Files
+
+File::File(FILE* file, const char* mode, unsigned long (*latency)()) : file(file, fclose), latency(latency){}
+
+void File::waitForSectors(size_t size){
+    if(latency == NULL || size == 0) return;
+    long first = ftell(file.get()) / SIZE_SD_SECTOR;
+    long last = (ftell(file.get()) + size - 1) / SIZE_SD_SECTOR;
+    for(long sector=first; sector<=last; sector++){
+        if(sector == cachedSector) continue;
+        unsigned long start = micros();
+        unsigned long wait = latency();
+        while(micros() - start < wait);
+    }
+    cachedSector = last;
+}
+
+int File::read(){
+    waitForSectors(1);
+    return fgetc(file.get());
+}
+
+int File::read(uint8_t* data, size_t size){
+    waitForSectors(size);
+    return fread(data, 1, size, file.get());
+}
+
+size_t File::write(const uint8_t* data, size_t size){
+    return fwrite(data, 1, size, file.get());
+}
+
+size_t File::write(uint8_t data){
+    return write(&data, 1);
+}
+
+bool File::seek(uint32_t pos, SeekMode mode){
+    return fseek(file.get(), pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+}
+
+uint32_t File::position(){
+    return ftell(file.get());
+}
+
+uint32_t File::size(){
+    fflush(file.get());
+    struct stat info;
+    return fstat(fileno(file.get()), &info) == 0 ? info.st_size : 0;
+}
+
+int File::available(){
+    return size() - position();
+}
+
+bool File::truncate(uint32_t size){
+    fflush(file.get());
+    return ftruncate(fileno(file.get()), size) == 0;
+}
+
+void File::flush(){
+    fflush(file.get());
+}
+
+void File::close(){
+    file.reset();
+}
+
+std::string hostPath(const char* path){
+    return fileRoot + (path[0] == '/' ? "" : "/") + path;
+}
+
+bool FSClass::exists(const char* path){
+    struct stat info;
+    return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+File FSClass::open(const char* path, const char* mode){
+    // Like on the ESP8266, FILE_WRITE opens in append mode, so every write goes to the end regardless of seek(),
+    // while LittleFS's "w" starts the file over
+    const char* hostMode = strcmp(mode, FILE_READ) == 0 ? "rb" : (strcmp(mode, "w") == 0 ? "w+b" : "a+b");
+    FILE* file = fopen(hostPath(path).c_str(), hostMode);
+    return file == NULL ? File() : File(file, mode, this == &SD ? sdLatency : NULL);
+}
+
+bool FSClass::mkdir(const char* path){
+    std::string full = hostPath(path);
+    for(size_t i=fileRoot.size()+1; i<=full.size(); i++){
+        if(i < full.size() && full[i] != '/') continue;
+        ::mkdir(full.substr(0, i).c_str(), 0755);
+    }
+    return exists(path);
+}
+
+bool FSClass::remove(const char* path){
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+// Network
+
+WiFiClient::WiFiClient(){
+    socket = -1;
+    timeout = 1000;
+}
+
+WiFiClient::~WiFiClient(){
+    stop();
+}
+
+int WiFiClient::connect(const char* host, uint16_t port){
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address;
+    if(getaddrinfo(host, NULL, &hints, &address) != 0) return 0;
+    ((sockaddr_in*)address->ai_addr)->sin_port = htons(port);
+
+    socket = ::socket(AF_INET, SOCK_STREAM, 0);
+    bool connected = ::connect(socket, address->ai_addr, address->ai_addrlen) == 0;
+    freeaddrinfo(address);
+    if(!connected) stop();
+    return connected;
+}
+
+uint8_t WiFiClient::connected(){
+    if(socket < 0) return 0;
+    if(available() > 0) return 1;
+    char c;
+    return recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT) != 0;
+}
+
+int WiFiClient::available(){
+    int count = 0;
+    if(socket < 0 || ioctl(socket, FIONREAD, &count) != 0) return 0;
+    return count;
+}
+
+int WiFiClient::read(){
+    uint8_t c;
+    if(socket < 0 || recv(socket, &c, 1, MSG_DONTWAIT) != 1) return -1;
+    bytesReceived++;
+    return c;
+}
+
+size_t WiFiClient::write(const uint8_t* data, size_t size){
+    if(socket < 0) return 0;
+    ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+    return sent < 0 ? 0 : sent;
+}
+
+size_t WiFiClient::print(const char* text){
+    return write((const uint8_t*)text, strlen(text));
+}
+
+void WiFiClient::setTimeout(unsigned long timeout){
+    this->timeout = timeout;
+}
+
+void WiFiClient::stop(){
+    if(socket < 0) return;
+    close(socket);
+    socket = -1;
+}
+
+void serve(int listener, std::string response, unsigned long (*latency)(), int rate){
+    while(true){
+        int client = accept(listener, NULL, NULL);
+        if(client < 0) return;
+
+        // Each request is answered on its own thread, so that a slow answer does not hold up the next request
+        std::thread([client, response, latency, rate]{
+            std::string request;
+            char buffer[256];
+            while(request.find("\r\n\r\n") == std::string::npos){
+                ssize_t size = recv(client, buffer, sizeof(buffer), 0);
+                if(size <= 0) break;
+                request.append(buffer, size);
+            }
+            delay(latency());
+
+            // A slow link is simulated by sending the response a little at a time
+            size_t chunk = rate > 0 ? 64 : response.size();
+            for(size_t sent=0; sent<response.size(); sent+=chunk){
+                if(sent > 0) delay(chunk * 1000 / rate);
+                send(client, response.data()+sent, min(chunk, response.size()-sent), MSG_NOSIGNAL);
+            }
+            close(client);
+        }).detach();
+    }
+}
+
+uint16_t startServer(const char* response, int size_response, unsigned long (*latency)(), int rate){
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (sockaddr*)&address, sizeof(address));
+    listen(listener, 16);
+
+    socklen_t size_address = sizeof(address);
+    getsockname(listener, (sockaddr*)&address, &size_address);
+    std::thread(serve, listener, std::string(response, size_response), latency, rate).detach();
+    return ntohs(address.sin_port);
+}
+
+// Audio
+
+// Like the I2S peripheral, the stand-in speaker is shared by all outputs
+unsigned long i2sStart = 0;
+uint64_t i2sConsumed = 0;
+uint32_t i2sHertz = 0;
+
+uint64_t i2sPlayed(){
+    return (micros() - i2sStart) * i2sHertz / 1000000;
+}
+
+bool i2s_is_empty(){
+    return i2sHertz > 0 && i2sConsumed <= i2sPlayed();
+}
+
+bool AudioOutputI2SNoDAC::begin(){
+    i2sStart = micros();
+    i2sConsumed = 0;
+    return true;
+}
+
+bool AudioOutputI2SNoDAC::ConsumeSample(int16_t sample[2]){
+    // Samples are accepted only as fast as they are played, plus what fits in the I2S DMA buffers on the ESP8266
+    i2sHertz = hertz;
+    if(hertz == 0) return true;
+    if(i2sConsumed < i2sPlayed()){
+        // The buffers ran dry and played silence, so the next sample is played from now on
+        i2sStart = micros() - i2sConsumed * 1000000 / hertz;
+    }
+    if(i2sConsumed >= i2sPlayed() + SIZE_DMA) return false;
+    i2sConsumed++;
+    unsigned long none = 0;
+    firstSample.compare_exchange_strong(none, micros());
+    return true;
+}
+
+bool AudioOutputI2SNoDAC::stop(){
+    return true;
+}
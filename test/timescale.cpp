@@ -0,0 +1,101 @@
+/**
+ * ATIS time-scale modification test.
+ * This file measures how fast the time-scaler runs on the host at several speech rates,
+ * and checks that it shortens the audio by the rate.
+ * Copyright (C) 2023-2024 PixelSergey
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <stdlib.h>
+
+#include "host.h"
+#include "timescale.h"
+
+#define RUNS 5
+#define HERTZ 22050
+#define SECONDS 10
+
+int failed = 0;
+
+void check(bool passed, const char* name){
+    printf("%-24s %s\n", name, passed ? "ok" : "FAIL");
+    failed += !passed;
+}
+
+// An output that only counts the samples written to it
+class AudioOutputCount : public AudioOutput {
+    public:
+        virtual bool begin() override { samples = 0; return true; }
+        virtual bool ConsumeSample(int16_t sample[2]) override { samples++; return true; }
+        virtual bool stop() override { return true; }
+
+        uint32_t samples;
+};
+
+/**
+ * @brief Time-scales a synthetic vowel several times and prints the median time it took against the length of the audio.
+ *
+ * @param[in] rate The playback rate in percent
+ * @param[out] samples The number of samples that came out, passed by reference
+ * @return The median number of seconds of audio processed per second of CPU time
+ */
+float measure(int rate, uint32_t& samples){
+    // A 150 Hz voice with a 700 Hz formant, the same signal that the benchmark on the ESP8266 uses
+    static int16_t signal[HERTZ*SECONDS];
+    for(int i=0; i<HERTZ*SECONDS; i++) signal[i] = 8000*sin(2*PI*150*i/HERTZ) + 4000*sin(2*PI*700*i/HERTZ);
+
+    unsigned long times[RUNS];
+    AudioOutputCount out;
+    for(int i=0; i<RUNS; i++){
+        AudioOutputTimeScale timescale(&out, rate);
+        timescale.SetRate(HERTZ);
+        timescale.SetChannels(1);
+        timescale.begin();
+
+        unsigned long start = micros();
+        for(int j=0; j<HERTZ*SECONDS; j++){
+            int16_t sample[2] = {signal[j], signal[j]};
+            timescale.ConsumeSample(sample);
+        }
+        timescale.stop();
+        times[i] = micros() - start;
+    }
+    samples = out.samples;
+
+    unsigned long p50 = percentile(times, RUNS, 50);
+    float realtime = SECONDS * 1e6 / max(p50, 1UL);
+    printf("%d%%: %d s of audio in %6.2f ms p50, %6.0fx realtime, %6u of %u samples out\n",
+        rate, SECONDS, p50/1000.0, realtime, samples, HERTZ*SECONDS);
+    return realtime;
+}
+
+int main(){
+    bool shortened = true;
+    float slowest = INFINITY;
+    for(int rate : {100, 125, 150, 200}){
+        uint32_t samples;
+        slowest = min(slowest, measure(rate, samples));
+        // Only the last partial segment is played out as it is, so the length is within one segment of the rate
+        uint32_t expected = (uint64_t)HERTZ * SECONDS * 100 / rate;
+        shortened = shortened && abs((int)samples - (int)expected) <= SIZE_TSM_FRAME;
+    }
+
+    check(shortened, "length");
+    // The ESP8266 is much slower than a computer, so the host has to run the kernel with a wide margin to spare
+    check(slowest >= 100, "throughput");
+
+    printf("%s\n", failed == 0 ? "PASS" : "FAIL");
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Reads the METAR history log written by ATIS to its SD card.
+
+Usage:
+    history.py history.bin --last 10
+    history.py history.bin --at 2024-05-01T12:00
+
+The record layout must be kept in sync with MetarRecord in atis/history.h.
+
+Copyright (C) 2023-2024 PixelSergey
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import mmap
+import struct
+from datetime import datetime, timezone
+
+RECORD = struct.Struct("<I4sHHBBHbbHBB3H4B")
+assert RECORD.size == 32
+
+# Must match weatherType in atis/helper.h
+WEATHER = ["VC", "RE", "MI", "BC", "PR", "DR", "BL", "SH", "TS", "FZ", "DZ", "RA", "SN", "SG", "PL",
+           "GR", "GS", "UP", "BR", "FG", "FU", "VA", "DU", "SA", "HZ", "PO", "SQ", "FC", "SS", "DS"]
+COVER = ["", "FEW", "SCT", "BKN", "OVC", "VV"]
+UNKNOWN = 0xFFFF
+VARIABLE = 0xFFFE
+UNKNOWN_TEMPERATURE = -128
+
+
+def temperature(value):
+    if value == UNKNOWN_TEMPERATURE:
+        return "//"
+    return ("M" if value < 0 else "") + "%02d" % abs(value)
+
+
+def describe(fields):
+    (time, station, issued, direction, speed, gust, visibility, temp, dewpoint, qnh, letter, flags,
+     *rest) = fields
+    clouds, weather = rest[:3], rest[3:]
+
+    groups = [station.decode(errors="replace"), "%02d%02d%02dZ" % (issued // 1440, issued // 60 % 24, issued % 60)]
+    if flags & 0x01:
+        groups.append("NIL")
+    if flags & 0x02:
+        groups.append("AUTO")
+    if direction == UNKNOWN:
+        groups.append("/////KT")
+    else:
+        wind = "VRB" if direction == VARIABLE else "%03d" % direction
+        groups.append(wind + "%02d" % speed + ("G%02d" % gust if gust else "") + "KT")
+    if flags & 0x04:
+        groups.append("CAVOK")
+    elif visibility != UNKNOWN:
+        groups.append("%04d" % visibility)
+    for value in weather:
+        if value:
+            intensity = "+" if value & 0x40 else "-" if value & 0x80 else ""
+            groups.append(intensity + WEATHER[(value & 0x3F) - 1])
+    for layer in clouds:
+        if layer:
+            kind = "CB" if layer & 0x1000 else "TCU" if layer & 0x0800 else ""
+            groups.append(COVER[layer >> 13] + "%03d" % (layer & 0x3FF) + kind)
+    if flags & 0x08:
+        groups.append("NSC")
+    if flags & 0x10:
+        groups.append("NCD")
+    groups.append(temperature(temp) + "/" + temperature(dewpoint))
+    groups.append("Q%04d" % qnh if qnh else "Q////")
+
+    received = datetime.fromtimestamp(time, timezone.utc).strftime("%Y-%m-%d %H:%M:%S")
+    return "%s %s %s" % (received, chr(ord("A") + letter), " ".join(groups))
+
+
+def find(log, count, time):
+    """Returns the index of the last record received at or before `time`, or -1."""
+    low, high = 0, count
+    while low < high:
+        middle = (low + high) // 2
+        if struct.unpack_from("<I", log, middle * RECORD.size)[0] <= time:
+            low = middle + 1
+        else:
+            high = middle
+    return low - 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("log", help="path to history.bin")
+    parser.add_argument("--last", type=int, help="print the most recent N reports")
+    parser.add_argument("--at", help="print the report that was current at a UTC time, e.g. 2024-05-01T12:00")
+    args = parser.parse_args()
+
+    with open(args.log, "rb") as file, mmap.mmap(file.fileno(), 0, access=mmap.ACCESS_READ) as log:
+        count = len(log) // RECORD.size
+        if args.at:
+            time = datetime.fromisoformat(args.at).replace(tzinfo=timezone.utc).timestamp()
+            index = find(log, count, time)
+            if index < 0:
+                raise SystemExit("No report before " + args.at)
+            print(describe(RECORD.unpack_from(log, index * RECORD.size)))
+            return
+
+        first = max(0, count - args.last) if args.last else 0
+        for fields in RECORD.iter_unpack(log[first * RECORD.size:count * RECORD.size]):
+            print(describe(fields))
+
+
+if __name__ == "__main__":
+    main()
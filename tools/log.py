@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+Turns the binary log written by ATIS to its serial port back into text.
+
+Usage:
+    log.py capture.bin
+    log.py --port /dev/ttyUSB0
+    log.py capture.bin --segments
+
+The events are read from the LOG_EVENTS table in atis/log.h, and token names from atis/helper.h,
+so the decoder always matches the firmware built from the same tree.
+
+Copyright (C) 2023-2024 PixelSergey
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import re
+import struct
+import sys
+from pathlib import Path
+
+SOURCE = Path(__file__).resolve().parent.parent / "atis"
+SYNC = 0xA5
+
+
+def read_events(source):
+    """Returns a list of (name, argument types, message) in the order of the LogEvent enum."""
+    header = (source / "log.h").read_text()
+    return re.findall(r'X\((\w+), \w+, "(\w*)", "([^"]*)"\)', header)
+
+
+def read_tokens(source):
+    """Returns the names of the TokenType enum in order."""
+    header = (source / "helper.h").read_text()
+    body = re.search(r"enum TokenType \{(.*?)\};", header, re.S).group(1)
+    body = re.sub(r"//.*", "", body)
+    return [name.strip() for name in body.split(",") if name.strip()]
+
+
+def decode_record(data, pos, events, tokens):
+    """Decodes the record at `pos`. Returns ((name, arguments, text), next position), None if more data is needed, or raises ValueError."""
+    if len(data) < pos + 6:
+        return None
+    event = data[pos + 1]
+    if event >= len(events):
+        raise ValueError("unknown event")
+    name, types, message = events[event]
+    time = struct.unpack_from("<I", data, pos + 2)[0]
+
+    pos += 6
+    arguments = []
+    for kind in types:
+        if kind == "i":
+            if len(data) < pos + 4:
+                return None
+            arguments.append(struct.unpack_from("<i", data, pos)[0])
+            pos += 4
+            continue
+
+        if len(data) < pos + 1 or len(data) < pos + 1 + data[pos]:
+            return None
+        value = data[pos + 1:pos + 1 + data[pos]]
+        pos += 1 + data[pos]
+        if kind == "s":
+            arguments.append(value.decode(errors="replace"))
+        else:
+            arguments.append(" ".join(tokens[t] if t < len(tokens) else str(t) for t in value))
+
+    text = message.format(*arguments)
+    return (name, arguments, "[%10.3f] %s" % (time / 1000, text)), pos
+
+
+def decode(read, events, tokens, handle):
+    """Reads the log with `read` until it returns nothing, and calls `handle` with the name, arguments and text of each record."""
+    data = b""
+    while True:
+        chunk = read()
+        if not chunk:
+            break
+        data += chunk
+
+        # Anything that is not a record, such as boot messages, is skipped until the next sync byte
+        pos = 0
+        while True:
+            pos = data.find(bytes([SYNC]), pos)
+            if pos < 0:
+                data = b""
+                break
+            try:
+                record = decode_record(data, pos, events, tokens)
+            except ValueError:
+                pos += 1
+                continue
+            if record is None:
+                data = data[pos:]
+                break
+            event, pos = record
+            handle(*event)
+
+
+def count_segments(totals):
+    """Returns a handler that adds up the SEGMENTS events, which are logged each time a new report's phrase is generated."""
+    def handle(name, arguments, text):
+        if name != "SEGMENTS":
+            return
+        reused, converted, time = arguments
+        totals["phrases"] += 1
+        totals["reused"] += reused
+        totals["converted"] += converted
+        totals["time"] += time
+    return handle
+
+
+def print_segments(totals):
+    pieces = totals["reused"] + totals["converted"]
+    if not pieces:
+        print("No phrases were generated in the background")
+        return
+    print("%d phrases: %d of %d pieces of information reused (%.1f %%), %.1f ms per phrase" % (
+        totals["phrases"], totals["reused"], pieces, 100 * totals["reused"] / pieces, totals["time"] / 1000 / totals["phrases"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("capture", nargs="?", help="file with the captured serial output, or - for standard input")
+    parser.add_argument("--port", help="serial port to read the log from live, requires pyserial")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--source", type=Path, default=SOURCE, help="directory with log.h and helper.h")
+    parser.add_argument("--segments", action="store_true", help="add up how much of each new report was reused from the previous one instead")
+    args = parser.parse_args()
+
+    events = read_events(args.source)
+    tokens = read_tokens(args.source)
+    if args.port:
+        import serial
+        port = serial.Serial(args.port, args.baud)
+        read = lambda: port.read(max(1, port.in_waiting))
+    else:
+        stream = open(args.capture, "rb") if args.capture and args.capture != "-" else sys.stdin.buffer
+        read = lambda: stream.read(256)
+
+    totals = {"phrases": 0, "reused": 0, "converted": 0, "time": 0}
+    handle = count_segments(totals) if args.segments else lambda name, arguments, text: print(text, flush=True)
+    try:
+        decode(read, events, tokens, handle)
+    except KeyboardInterrupt:
+        pass
+    if args.segments:
+        print_segments(totals)
+
+
+if __name__ == "__main__":
+    main()
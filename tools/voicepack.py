@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Converts an ATIS voicepack into another audio format with ffmpeg.
+
+Usage:
+    voicepack.py audio/female audio/female_adpcm --format adpcm
+
+The formats are mp3, wav (16-bit PCM), wav8 (8-bit PCM) and adpcm (IMA-ADPCM).
+The new voicepack's format.txt is written so that ATIS decodes it correctly,
+and its cost can be compared to the original with the BENCHMARK setting in config.h.
+
+Copyright (C) 2023-2024 PixelSergey
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+"""
+
+import argparse
+import shutil
+import subprocess
+from pathlib import Path
+
+# The format name written to format.txt, the file extension and the ffmpeg codec options of each format
+FORMATS = {
+    "mp3": ("mp3", "mp3", ["-codec:a", "libmp3lame", "-q:a", "5"]),
+    "wav": ("wav", "wav", ["-codec:a", "pcm_s16le"]),
+    "wav8": ("wav", "wav", ["-codec:a", "pcm_u8"]),
+    "adpcm": ("adpcm", "wav", ["-codec:a", "adpcm_ima_wav", "-block_size", "256"]),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("source", type=Path, help="directory of the voicepack to convert")
+    parser.add_argument("target", type=Path, help="directory of the new voicepack")
+    parser.add_argument("--format", choices=FORMATS, required=True)
+    parser.add_argument("--rate", type=int, help="resample the clips to this rate in Hz")
+    args = parser.parse_args()
+
+    name, extension, codec = FORMATS[args.format]
+    args.target.mkdir(parents=True, exist_ok=True)
+    options = ["-ac", "1"] + (["-ar", str(args.rate)] if args.rate else [])
+
+    for clip in sorted(args.source.glob("*.mp3")) + sorted(args.source.glob("*.wav")):
+        output = args.target / (clip.stem + "." + extension)
+        subprocess.run(["ffmpeg", "-loglevel", "error", "-y", "-i", str(clip)] + options + codec + [str(output)], check=True)
+
+    for extra in ["compound.txt"]:
+        if (args.source / extra).exists():
+            shutil.copy(args.source / extra, args.target / extra)
+    (args.target / "format.txt").write_text(name + "\n")
+
+
+if __name__ == "__main__":
+    main()